@@ -30,6 +30,8 @@
 #endif
 
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 #define FRACTION        12
 #define FLOOR(i)        ((i) & (~0UL << FRACTION))
@@ -370,6 +372,19 @@ static void RrImageSetAddName(RrImageSet *set, const gchar *name)
     g_hash_table_insert(set->cache->name_table, n, set);
 }
 
+static void RrImageSetRemoveName(RrImageSet *set, const gchar *name)
+{
+    GSList *it;
+
+    for (it = set->names; it; it = g_slist_next(it))
+        if (!strcmp(it->data, name)) {
+            g_hash_table_remove(set->cache->name_table, it->data);
+            g_free(it->data);
+            set->names = g_slist_delete_link(set->names, it);
+            break;
+        }
+}
+
 
 /************************************************************************
  RrImage functions.
@@ -431,6 +446,19 @@ void RrImageAddFromData(RrImage *self, RrPixel32 *data, gint w, gint h)
     }
 }
 
+/*! Makes an RrImage with no pictures in it, in a new RrImageSet */
+static RrImage* RrImageNewEmpty(RrImageCache *cache)
+{
+    RrImage *self;
+
+    self = g_slice_new0(RrImage);
+    self->ref = 1;
+    self->set = g_slice_new0(RrImageSet);
+    self->set->cache = cache;
+    self->set->images = g_slist_append(self->set->images, self);
+    return self;
+}
+
 RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
                             gint w, gint h)
 {
@@ -456,11 +484,7 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
        a new RrImageSet, and a new RrImage that points to it, and place the
        new image inside the new RrImageSet */
 
-    self = g_slice_new0(RrImage);
-    self->ref = 1;
-    self->set = g_slice_new0(RrImageSet);
-    self->set->cache = cache;
-    self->set->images = g_slist_append(self->set->images, self);
+    self = RrImageNewEmpty(cache);
 
     ppic = RrImagePicNew(w, h, data);
     RrImageSetAddPicture(self->set, ppic, TRUE);
@@ -606,6 +630,267 @@ RsvgLoader* LoadWithRsvg(gchar *path,
 }
 #endif  /* USE_LIBRSVG */
 
+#if defined(USE_LIBRSVG)
+#define SVG_CACHE_MAGIC 0x4f425356 /* "OBSV" */
+/*! Saved pictures older than this are removed, so ones for files which are
+  gone or changed don't pile up */
+#define SVG_CACHE_MAX_AGE (30 * 24 * 60 * 60) /* seconds */
+
+/*! Finds where the picture rendered from an SVG file is saved.  It is named
+  for the file's path, modification time and size, so a changed file is
+  rendered again. */
+static gchar* SvgCachePath(const gchar *path)
+{
+    GStatBuf st;
+    gchar *key, *sum, *file;
+
+    if (g_stat(path, &st) != 0)
+        return NULL;
+
+    key = g_strdup_printf("%s\n%" G_GINT64_FORMAT "\n%" G_GINT64_FORMAT,
+                          path, (gint64)st.st_mtime, (gint64)st.st_size);
+    sum = g_compute_checksum_for_string(G_CHECKSUM_MD5, key, -1);
+    file = g_build_filename(g_get_user_cache_dir(), "openbox", "svg", sum,
+                            NULL);
+    g_free(sum);
+    g_free(key);
+    return file;
+}
+
+/*! The saved picture is SVG_CACHE_MAGIC, the width and height, then the
+  pixels, all in native byte order */
+static RrPixel32* SvgCacheRead(const gchar *file, gint *width, gint *height)
+{
+    gchar *contents;
+    gsize len;
+    guint32 *head;
+    RrPixel32 *data = NULL;
+
+    if (!g_file_get_contents(file, &contents, &len, NULL))
+        return NULL;
+
+    head = (guint32*)contents;
+    if (len >= 3 * sizeof(guint32) && head[0] == SVG_CACHE_MAGIC &&
+        head[1] > 0 && head[2] > 0 &&
+        (guint64)head[1] * head[2] == len / sizeof(guint32) - 3 &&
+        len % sizeof(guint32) == 0)
+    {
+        *width = head[1];
+        *height = head[2];
+        data = g_memdup2(head + 3, len - 3 * sizeof(guint32));
+    }
+    g_free(contents);
+    return data;
+}
+
+/*! Removes the saved pictures which are older than SVG_CACHE_MAX_AGE */
+static void SvgCachePrune(const gchar *dir)
+{
+    GDir *d;
+    const gchar *name;
+    gint64 now;
+
+    if (!(d = g_dir_open(dir, 0, NULL)))
+        return;
+
+    now = g_get_real_time() / G_USEC_PER_SEC;
+    while ((name = g_dir_read_name(d))) {
+        gchar *file = g_build_filename(dir, name, NULL);
+        GStatBuf st;
+
+        if (g_stat(file, &st) == 0 && S_ISREG(st.st_mode) &&
+            now - (gint64)st.st_mtime > SVG_CACHE_MAX_AGE)
+            g_unlink(file);
+        g_free(file);
+    }
+    g_dir_close(d);
+}
+
+static void SvgCacheWrite(const gchar *file, RrPixel32 *data,
+                          gint width, gint height)
+{
+    static gsize pruned = 0;
+    gchar *dir;
+    guint32 *contents;
+    gsize len;
+
+    dir = g_path_get_dirname(file);
+
+    /* the cache only grows when pictures are written, so clean it up once
+       then */
+    if (g_once_init_enter(&pruned)) {
+        SvgCachePrune(dir);
+        g_once_init_leave(&pruned, 1);
+    }
+
+    if (g_mkdir_with_parents(dir, 0700) == 0) {
+        len = (3 + (gsize)width * height) * sizeof(guint32);
+        contents = g_malloc(len);
+        contents[0] = SVG_CACHE_MAGIC;
+        contents[1] = width;
+        contents[2] = height;
+        memcpy(contents + 3, data, (gsize)width * height * sizeof(RrPixel32));
+        /* it is only a cache, so it does not matter if this fails */
+        g_file_set_contents(file, (gchar*)contents, len, NULL);
+        g_free(contents);
+    }
+    g_free(dir);
+}
+#endif  /* USE_LIBRSVG */
+
+#if defined(USE_IMLIB2)
+/*! Imlib2 keeps its state in a global context, so only one thread can use it
+  at a time */
+static GMutex imlib_lock;
+#endif
+
+/*! Loads the picture from a file.  This is called in the loading threads, so
+  it must not touch the RrImageCache.
+  @return The picture, which should be freed with g_free(), or NULL if the
+    file could not be loaded.
+*/
+static RrPixel32* LoadFile(const gchar *path, gint *width, gint *height)
+{
+    RrPixel32 *data = NULL;
+#if defined(USE_IMLIB2) || defined(USE_LIBRSVG)
+    RrPixel32 *loaded;
+#endif
+#if defined(USE_LIBRSVG)
+    RsvgLoader *rsvg_loader;
+    gchar *cache_file;
+
+    cache_file = SvgCachePath(path);
+    if (cache_file && (data = SvgCacheRead(cache_file, width, height))) {
+        g_free(cache_file);
+        return data;
+    }
+
+    if ((rsvg_loader = LoadWithRsvg((gchar*)path, &loaded, width, height))) {
+        /* take the pixels from the loader instead of copying them */
+        data = loaded;
+        rsvg_loader->pixel_data = NULL;
+        DestroyRsvgLoader(rsvg_loader);
+
+        if (cache_file)
+            SvgCacheWrite(cache_file, data, *width, *height);
+    }
+    g_free(cache_file);
+#endif
+#if defined(USE_IMLIB2)
+    if (!data) {
+        ImlibLoader *imlib_loader;
+
+        g_mutex_lock(&imlib_lock);
+        imlib_loader = LoadWithImlib((gchar*)path, &loaded, width, height);
+        if (imlib_loader) {
+            data = g_memdup2(loaded, *width * *height * sizeof(RrPixel32));
+            DestroyImlibLoader(imlib_loader);
+        }
+        g_mutex_unlock(&imlib_lock);
+    }
+#else
+    (void)path; (void)width; (void)height;
+#endif
+    return data;
+}
+
+/*! Images are loaded by at most this many threads at once */
+#define MAX_LOAD_THREADS 4
+
+/*! A file being loaded for an RrImage that was returned empty */
+typedef struct _RrImageLoad {
+    RrImageCache *cache;
+    gchar *name;
+    RrPixel32 *data;
+    gint w, h;
+} RrImageLoad;
+
+static GThreadPool *load_pool = NULL;
+
+/*! Puts the loaded picture into the image, back in the main thread */
+static gboolean RrImageLoadDone(gpointer data)
+{
+    RrImageLoad *load = data;
+    RrImageSet *set;
+    RrImage *self;
+
+    g_hash_table_remove(load->cache->loading_table, load->name);
+
+    /* the image is found by its name, as it may have been freed already, and
+       even replaced with a new one */
+    set = g_hash_table_lookup(load->cache->name_table, load->name);
+
+    if (!load->data) {
+        g_message("Cannot load image \"%s\" from file \"%s\"",
+                  load->name, load->name);
+        if (set && set->n_original == 0) {
+            self = set->images->data;
+
+            /* forget the name so the next time it is asked for the file is
+               tried again, the way it is when loading right away */
+            RrImageRef(self);
+            RrImageSetRemoveName(set, load->name);
+            if (load->cache->loaded_func)
+                load->cache->loaded_func(self, FALSE,
+                                         load->cache->loaded_data);
+            RrImageUnref(self);
+        }
+    }
+    else if (set && set->n_original == 0) {
+        self = set->images->data;
+
+        RrImageRef(self);
+        RrImageAddFromData(self, load->data, load->w, load->h);
+        if (load->cache->loaded_func)
+            load->cache->loaded_func(self, TRUE, load->cache->loaded_data);
+        RrImageUnref(self);
+    }
+
+    g_free(load->data);
+    g_free(load->name);
+    RrImageCacheUnref(load->cache);
+    g_slice_free(RrImageLoad, load);
+    return FALSE; /* don't repeat */
+}
+
+static void RrImageLoadThread(gpointer data,
+                              G_GNUC_UNUSED gpointer user_data)
+{
+    RrImageLoad *load = data;
+
+    /* XXX find the path via freedesktop icon spec (use obt) ! */
+    load->data = LoadFile(load->name, &load->w, &load->h);
+    g_idle_add(RrImageLoadDone, load);
+}
+
+/*! Starts loading the named file in another thread.
+  @return FALSE if the loading threads could not be started. */
+static gboolean RrImageLoadStart(RrImageCache *cache, const gchar *name)
+{
+    RrImageLoad *load;
+
+    if (!load_pool) {
+        load_pool = g_thread_pool_new(RrImageLoadThread, NULL,
+                                      CLAMP(g_get_num_processors(), 1,
+                                            MAX_LOAD_THREADS),
+                                      FALSE, NULL);
+        if (!load_pool) return FALSE;
+    }
+
+    /* an empty image made for the name may have been freed while it was
+       loading.  the one made now gets filled in by that load */
+    if (g_hash_table_lookup_extended(cache->loading_table, name, NULL, NULL))
+        return TRUE;
+    g_hash_table_insert(cache->loading_table, g_strdup(name), NULL);
+
+    load = g_slice_new0(RrImageLoad);
+    load->cache = cache;
+    RrImageCacheRef(cache);
+    load->name = g_strdup(name);
+    g_thread_pool_push(load_pool, load, NULL);
+    return TRUE;
+}
+
 RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
 {
     RrImage *self;
@@ -613,14 +898,6 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
     gint w, h;
     RrPixel32 *data;
     gchar *path;
-    gboolean loaded;
-
-#if defined(USE_IMLIB2)
-    ImlibLoader *imlib_loader = NULL;
-#endif
-#if defined(USE_LIBRSVG)
-    RsvgLoader *rsvg_loader = NULL;
-#endif
 
     g_return_val_if_fail(cache != NULL, NULL);
     g_return_val_if_fail(name != NULL, NULL);
@@ -632,32 +909,20 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
         return self;
     }
 
+    /* give back an empty image with the name, and fill it in once the file is
+       loaded.  asking for the name again before then gives the same image */
+    if (cache->loaded_func && RrImageLoadStart(cache, name)) {
+        self = RrImageNewEmpty(cache);
+        RrImageSetAddName(self->set, name);
+        return self;
+    }
+
     /* XXX find the path via freedesktop icon spec (use obt) ! */
     path = g_strdup(name);
 
-    loaded = FALSE;
-#if defined(USE_LIBRSVG)
-    if (!loaded) {
-        rsvg_loader = LoadWithRsvg(path, &data, &w, &h);
-        loaded = !!rsvg_loader;
-    }
-#endif
-#if defined(USE_IMLIB2)
-    if (!loaded) {
-        imlib_loader = LoadWithImlib(path, &data, &w, &h);
-        loaded = !!imlib_loader;
-    }
-#endif
-
-    if (!loaded) {
+    if (!(data = LoadFile(path, &w, &h))) {
         g_message("Cannot load image \"%s\" from file \"%s\"", name, path);
         g_free(path);
-#if defined(USE_LIBRSVG)
-        DestroyRsvgLoader(rsvg_loader);
-#endif
-#if defined(USE_IMLIB2)
-        DestroyImlibLoader(imlib_loader);
-#endif
         return NULL;
     }
 
@@ -676,12 +941,7 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
     self = RrImageNewFromData(cache, data, w, h);
     RrImageSetAddName(self->set, name);
 
-#if defined(USE_LIBRSVG)
-    DestroyRsvgLoader(rsvg_loader);
-#endif
-#if defined(USE_IMLIB2)
-    DestroyImlibLoader(imlib_loader);
-#endif
+    g_free(data);
 
     return self;
 }
@@ -911,6 +1171,10 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
     pic = NULL;
     free_pic = FALSE;
 
+    /* it is still being loaded, so there is nothing to draw yet */
+    if (set->n_original == 0)
+        return;
+
     /* is there an original of this size? (only the larger of
        w or h has to be right cuz we maintain aspect ratios) */
     for (i = 0; i < set->n_original; ++i)
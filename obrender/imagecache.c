@@ -35,9 +35,20 @@ RrImageCache* RrImageCacheNew(gint max_resized_saved)
     self->pic_table = g_hash_table_new((GHashFunc)RrImagePicHash,
                                        (GEqualFunc)RrImagePicEqual);
     self->name_table = g_hash_table_new(g_str_hash, g_str_equal);
+    self->loaded_func = NULL;
+    self->loaded_data = NULL;
+    self->loading_table = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                g_free, NULL);
     return self;
 }
 
+void RrImageCacheSetLoadedFunc(RrImageCache *self, RrImageLoadedFunc func,
+                               gpointer data)
+{
+    self->loaded_func = func;
+    self->loaded_data = data;
+}
+
 void RrImageCacheRef(RrImageCache *self)
 {
     ++self->ref;
@@ -54,6 +65,10 @@ void RrImageCacheUnref(RrImageCache *self)
         g_hash_table_destroy(self->name_table);
         self->name_table = NULL;
 
+        g_assert(g_hash_table_size(self->loading_table) == 0);
+        g_hash_table_destroy(self->loading_table);
+        self->loading_table = NULL;
+
         g_slice_free(RrImageCache, self);
     }
 }
@@ -19,7 +19,7 @@
 #ifndef __imagecache_h
 #define __imagecache_h
 
-#include <glib.h>
+#include "render.h"
 
 struct _RrImagePic;
 
@@ -53,6 +53,14 @@ struct _RrImageCache {
     /*! Used to find out if an image file has already been loaded into an
       image set. Provides a quick file_name -> RrImageSet lookup. */
     GHashTable *name_table;
+
+    /*! When not NULL, images are loaded from files in other threads, and this
+      is called when each one has been loaded. */
+    RrImageLoadedFunc loaded_func;
+    gpointer loaded_data;
+    /*! The names of the files being loaded in other threads, so each is
+      only loaded once at a time */
+    GHashTable *loading_table;
 };
 
 #endif
@@ -25,6 +25,7 @@
 #include "color.h"
 #include "image.h"
 #include "theme.h"
+#include "obt/trace.h"
 
 #include <glib.h>
 #include <X11/Xlib.h>
@@ -38,7 +39,37 @@
 static void pixel_data_to_pixmap(RrAppearance *l,
                                  gint x, gint y, gint w, gint h);
 
+/*! How many times each type of surface was painted, and for how long */
+static gulong paint_count[RR_SURFACE_NUM_TYPES];
+static gint64 paint_usec[RR_SURFACE_NUM_TYPES];
+
+static Pixmap paint_pixmap(RrAppearance *a, gint w, gint h);
+
 Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
+{
+    gint64 start;
+    Pixmap oldp;
+
+    OBT_TRACE_BEGIN("RrPaintPixmap");
+    start = g_get_monotonic_time();
+    oldp = paint_pixmap(a, w, h);
+    ++paint_count[a->surface.grad];
+    paint_usec[a->surface.grad] += g_get_monotonic_time() - start;
+    OBT_TRACE_END("RrPaintPixmap");
+    return oldp;
+}
+
+void RrPaintStats(gulong *count, gint64 *usec)
+{
+    gint i;
+
+    for (i = 0; i < RR_SURFACE_NUM_TYPES; ++i) {
+        count[i] = paint_count[i];
+        usec[i] = paint_usec[i];
+    }
+}
+
+static Pixmap paint_pixmap(RrAppearance *a, gint w, gint h)
 {
     gint i, transferred = 0, force_transfer = 0;
     Pixmap oldp = None;
@@ -187,6 +218,19 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
     return oldp;
 }
 
+Pixmap RrTakePixmap(RrAppearance *a)
+{
+    Pixmap p = a->pixmap;
+
+    /* the xftdraw draws into the pixmap, so it goes with it */
+    if (a->xftdraw != NULL) {
+        XftDrawDestroy(a->xftdraw);
+        a->xftdraw = NULL;
+    }
+    a->pixmap = None;
+    return p;
+}
+
 void RrPaint(RrAppearance *a, Window win, gint w, gint h)
 {
     Pixmap oldp;
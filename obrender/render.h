@@ -243,6 +243,8 @@ struct _RrImagePic {
 };
 
 typedef void (*RrImageDestroyFunc)(RrImage *image, gpointer data);
+typedef void (*RrImageLoadedFunc)(RrImage *image, gboolean loaded,
+                                  gpointer data);
 
 /*! An RrImage refers to a RrImageSet.  If multiple RrImageSets end up
   holding the same image data, they will be marged and the RrImages that
@@ -402,7 +404,16 @@ gint    RrFontMaxCharWidth  (const RrFont *f);
    is the responsibility of the caller to call XFreePixmap on the return when
    it is non-null. */
 Pixmap RrPaintPixmap (RrAppearance *a, gint w, gint h);
+/* Take the pixmap that was last painted away from the appearance, so the
+   caller can keep it after the appearance paints again.  It is the
+   responsibility of the caller to call XFreePixmap on the return when it is
+   non-null. */
+Pixmap RrTakePixmap  (RrAppearance *a);
 void   RrPaint       (RrAppearance *a, Window win, gint w, gint h);
+/* Gives the number of times that each RrSurfaceColorType has been painted,
+   and the total microseconds spent doing it.  Both arrays must have
+   RR_SURFACE_NUM_TYPES elements. */
+void   RrPaintStats  (gulong *count, gint64 *usec);
 void   RrMinSize     (RrAppearance *a, gint *w, gint *h);
 gint   RrMinWidth    (RrAppearance *a);
 /* For text textures, if flow is TRUE, then the string must be set before
@@ -420,6 +431,16 @@ gboolean RrPixmapToRGBA(const RrInstance *inst,
 RrImageCache* RrImageCacheNew(gint max_resized_saved);
 void          RrImageCacheRef(RrImageCache *self);
 void          RrImageCacheUnref(RrImageCache *self);
+/*! Makes RrImageNewFromName load images from files in other threads.  It
+  returns an empty image which has the picture added to it when it has been
+  loaded, and then @func is called with the image so it can be drawn again.
+  If the file could not be loaded, @func is called with loaded FALSE and the
+  image stays empty, so it should be let go of.  Pass NULL to load them right
+  away again.
+*/
+void          RrImageCacheSetLoadedFunc(RrImageCache *self,
+                                        RrImageLoadedFunc func,
+                                        gpointer data);
 
 /*! Create a new image, or return one from the cache that matches.
   @param cache The image cache.
@@ -429,7 +450,8 @@ void          RrImageCacheUnref(RrImageCache *self);
     Pass NULL here if adding an image which is (or may be) entirely new.
   @param name The name of the icon to be loaded off disk, or used in the cache
   @return Returns NULL if unable to load an image by the name and it is not in
-    the cache already
+    the cache already.  If the cache has an RrImageLoadedFunc, then the image
+    is empty until it has been loaded, and is never NULL.
 */
 RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name);
 
@@ -0,0 +1,377 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   render_bench.c for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Times the pieces of obrender that openbox uses to draw its decorations:
+   the gradients for every surface type, painting a whole titlebar into a
+   pixmap, drawing and scaling icons, converting to the screen's pixel
+   format, and measuring text.  Each one is repeated for the given number of
+   seconds, and reported as time per call, time per pixel (or character),
+   and memory allocations per call.
+
+   It needs an X display for the RrInstance, which can be an Xvfb, but it
+   does not show anything on the screen.
+
+   usage: render_bench [seconds per benchmark]
+*/
+
+#include "render.h"
+#include "color.h"
+#include "gradient.h"
+#include "image.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#ifdef __GLIBC__
+/* count every allocation made by anything in the process.  glib's slice
+   allocator is told to use malloc too, in main() */
+extern void *__libc_malloc(size_t n);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t n);
+
+static gulong allocs = 0;
+
+void *malloc(size_t n)
+{
+    ++allocs;
+    return __libc_malloc(n);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    ++allocs;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t n)
+{
+    ++allocs;
+    return __libc_realloc(p, n);
+}
+#define COUNT_ALLOCS 1
+#endif
+
+typedef void (*BenchFunc)(gpointer data);
+
+static gdouble seconds = 0.25;
+
+/*! Runs @func over and over for the benchmark's time, and prints how long
+  one call took, and per @units of work (pixels or characters) */
+static void run(const gchar *name, const gchar *size, const gchar *unit,
+                gulong units, BenchFunc func, gpointer data)
+{
+    GTimer *t;
+    gulong calls, start_allocs = 0, end_allocs = 0;
+    gdouble elapsed;
+
+    /* once to warm up the caches */
+    func(data);
+
+    t = g_timer_new();
+#ifdef COUNT_ALLOCS
+    start_allocs = allocs;
+#endif
+    calls = 0;
+    do {
+        func(data);
+        ++calls;
+    } while ((elapsed = g_timer_elapsed(t, NULL)) < seconds);
+#ifdef COUNT_ALLOCS
+    end_allocs = allocs;
+#endif
+    g_timer_destroy(t);
+
+    printf("%-24s %-10s %10.0f ns/call %9.3f ns/%-5s",
+           name, size, elapsed * 1e9 / calls,
+           elapsed * 1e9 / calls / units, unit);
+#ifdef COUNT_ALLOCS
+    printf(" %7.1f allocs/call\n",
+           (gdouble)(end_allocs - start_allocs) / calls);
+#else
+    printf("       ? allocs/call\n");
+#endif
+}
+
+/*! The sizes things are drawn at in openbox: a button, a titlebar, the
+  focus cycle popup, and a panel across the screen */
+static const struct { gint w, h; } sizes[] = {
+    { 16, 16 }, { 200, 20 }, { 300, 200 }, { 1280, 24 }
+};
+#define NUM_SIZES (gint)(sizeof(sizes) / sizeof(sizes[0]))
+
+static const gchar *surface_names[RR_SURFACE_NUM_TYPES] = {
+    "none", "parentrelative", "solid", "splitvertical", "horizontal",
+    "vertical", "diagonal", "crossdiagonal", "pyramid", "mirrorhorizontal"
+};
+
+typedef struct {
+    RrAppearance *a;
+    gint w, h;
+} RenderData;
+
+static RrAppearance* make_appearance(RrInstance *inst,
+                                     RrSurfaceColorType grad, gint numtex)
+{
+    RrAppearance *a;
+
+    a = RrAppearanceNew(inst, numtex);
+    a->surface.grad = grad;
+    a->surface.relief = RR_RELIEF_FLAT;
+    a->surface.primary = RrColorNew(inst, 0x40, 0x60, 0xa0);
+    a->surface.secondary = RrColorNew(inst, 0xc0, 0xd0, 0xf0);
+    a->surface.split_primary = RrColorNew(inst, 0x50, 0x70, 0xb0);
+    a->surface.split_secondary = RrColorNew(inst, 0xd0, 0xe0, 0xff);
+    return a;
+}
+
+static void bench_render(gpointer data)
+{
+    RenderData *d = data;
+    RrRender(d->a, d->w, d->h);
+}
+
+static void bench_paint(gpointer data)
+{
+    RenderData *d = data;
+    Pixmap old;
+
+    old = RrPaintPixmap(d->a, d->w, d->h);
+    if (old) XFreePixmap(RrDisplay(d->a->inst), old);
+    /* wait for the server to draw it too */
+    XSync(RrDisplay(d->a->inst), FALSE);
+}
+
+typedef struct {
+    RrPixel32 *target;
+    gint w, h;
+    RrTextureRGBA rgba;
+    RrRect area;
+} DrawData;
+
+static void bench_draw(gpointer data)
+{
+    DrawData *d = data;
+    RrImageDrawRGBA(d->target, &d->rgba, d->w, d->h, &d->area);
+}
+
+typedef struct {
+    const RrInstance *inst;
+    RrPixel32 *src;
+    gchar *dest;
+    XImage im;
+} ReduceData;
+
+static void bench_reduce(gpointer data)
+{
+    ReduceData *d = data;
+
+    /* at 32bpp it may just point the image at the source */
+    d->im.data = d->dest;
+    RrReduceDepth(d->inst, d->src, &d->im);
+}
+
+typedef struct {
+    RrFont *font;
+    const gchar *str;
+} MeasureData;
+
+static void bench_measure(gpointer data)
+{
+    MeasureData *d = data;
+    g_slice_free(RrSize, RrFontMeasureString(d->font, d->str, 1, 1,
+                                             FALSE, 0));
+}
+
+static RrPixel32* make_icon(gint w, gint h)
+{
+    RrPixel32 *p;
+    gint i;
+
+    p = g_new(RrPixel32, w * h);
+    for (i = 0; i < w * h; ++i)
+        p[i] = ((RrPixel32)(i % 256) << RrDefaultAlphaOffset) |
+            ((i * 7) & 0xffffff);
+    return p;
+}
+
+gint main(gint argc, gchar **argv)
+{
+    Display *display;
+    RrInstance *inst;
+    gint s, g, bpp;
+    gchar *size;
+
+    /* make g_slice use malloc, so its allocations are counted too */
+    g_setenv("G_SLICE", "always-malloc", TRUE);
+
+    if (argc > 1) seconds = MAX(0.01, atof(argv[1]));
+
+    if (!(display = XOpenDisplay(NULL))) {
+        fprintf(stderr, "couldn't connect to the X server\n");
+        return 1;
+    }
+    inst = RrInstanceNew(display, DefaultScreen(display));
+
+    /* the gradients, into memory */
+    for (g = RR_SURFACE_SOLID; g < RR_SURFACE_NUM_TYPES; ++g)
+        for (s = 0; s < NUM_SIZES; ++s) {
+            RenderData d;
+            gchar *name;
+
+            d.a = make_appearance(inst, g, 0);
+            d.w = sizes[s].w;
+            d.h = sizes[s].h;
+            d.a->surface.pixel_data = g_new(RrPixel32, d.w * d.h);
+
+            name = g_strdup_printf("render %s", surface_names[g]);
+            size = g_strdup_printf("%dx%d", d.w, d.h);
+            run(name, size, "pixel", d.w * d.h, bench_render, &d);
+            g_free(size);
+            g_free(name);
+
+            RrAppearanceFree(d.a);
+        }
+
+    /* a whole titlebar with its text and icon, into a pixmap on the
+       server */
+    for (s = 1; s < NUM_SIZES; ++s) {
+        RenderData d;
+        RrPixel32 *icon;
+
+        d.w = sizes[s].w;
+        d.h = sizes[s].h;
+        d.a = make_appearance(inst, RR_SURFACE_VERTICAL, 2);
+
+        /* the icon has to come first, drawing text sends the pixels to the
+           server */
+        icon = make_icon(16, 16);
+        d.a->texture[0].type = RR_TEXTURE_RGBA;
+        d.a->texture[0].data.rgba.width = 16;
+        d.a->texture[0].data.rgba.height = 16;
+        d.a->texture[0].data.rgba.alpha = 0xff;
+        d.a->texture[0].data.rgba.data = icon;
+        d.a->texture[0].data.rgba.tx = 2;
+        d.a->texture[0].data.rgba.ty = 2;
+        d.a->texture[0].data.rgba.twidth = 16;
+        d.a->texture[0].data.rgba.theight = 16;
+
+        d.a->texture[1].type = RR_TEXTURE_TEXT;
+        d.a->texture[1].data.text.font = RrFontOpenDefault(inst);
+        d.a->texture[1].data.text.color = RrColorNew(inst, 0xff, 0xff, 0xff);
+        d.a->texture[1].data.text.justify = RR_JUSTIFY_LEFT;
+        d.a->texture[1].data.text.ellipsize = RR_ELLIPSIZE_END;
+        d.a->texture[1].data.text.string =
+            "A window title - Some Application";
+
+        size = g_strdup_printf("%dx%d", d.w, d.h);
+        run("paint titlebar", size, "pixel", d.w * d.h, bench_paint, &d);
+        g_free(size);
+
+        RrFontClose(d.a->texture[1].data.text.font);
+        RrColorFree(d.a->texture[1].data.text.color);
+        RrAppearanceFree(d.a);
+        g_free(icon);
+    }
+
+    /* icons, at their own size (DrawRGBA) and scaled (ResizeImage and
+       DrawRGBA) */
+    {
+        static const struct { gint src, dest; } icons[] = {
+            { 48, 48 }, { 128, 48 }, { 48, 16 }, { 16, 48 }
+        };
+        gint i;
+
+        for (i = 0; i < (gint)(sizeof(icons) / sizeof(icons[0])); ++i) {
+            DrawData d;
+
+            d.w = d.h = icons[i].dest;
+            d.target = g_new0(RrPixel32, d.w * d.h);
+            d.rgba.width = d.rgba.height = icons[i].src;
+            d.rgba.alpha = 0xff;
+            d.rgba.data = make_icon(icons[i].src, icons[i].src);
+            RECT_SET(d.area, 0, 0, d.w, d.h);
+
+            size = g_strdup_printf("%d->%d", icons[i].src, icons[i].dest);
+            run(icons[i].src == icons[i].dest ? "draw rgba" :
+                "draw rgba scaled", size, "pixel", d.w * d.h,
+                bench_draw, &d);
+            g_free(size);
+
+            g_free(d.rgba.data);
+            g_free(d.target);
+        }
+    }
+
+    /* converting to the screen's format.  The colour offsets come from the
+       screen's visual, so only the loop for the other depths is
+       representative, not the colours it produces */
+    for (bpp = 16; bpp <= 32; bpp += 8)
+        for (s = 1; s < NUM_SIZES; ++s) {
+            ReduceData d;
+            gchar *name;
+
+            memset(&d.im, 0, sizeof(d.im));
+            d.inst = inst;
+            d.im.width = sizes[s].w;
+            d.im.height = sizes[s].h;
+            d.im.bits_per_pixel = bpp;
+            d.im.bytes_per_line = (d.im.width * bpp / 8 + 3) & ~3;
+            d.src = make_icon(d.im.width, d.im.height);
+            d.dest = g_new(gchar, d.im.bytes_per_line * d.im.height);
+
+            name = g_strdup_printf("reduce depth %dbpp", bpp);
+            size = g_strdup_printf("%dx%d", d.im.width, d.im.height);
+            run(name, size, "pixel", d.im.width * d.im.height,
+                bench_reduce, &d);
+            g_free(size);
+            g_free(name);
+
+            g_free(d.dest);
+            g_free(d.src);
+        }
+
+    /* measuring text, as for window titles and menu entries */
+    {
+        MeasureData d;
+        GString *str;
+        gint len;
+
+        d.font = RrFontOpenDefault(inst);
+        str = g_string_new(NULL);
+        for (len = 32; len <= 2048; len *= 4) {
+            while ((gint)str->len < len)
+                g_string_append(str, "Some Window Title - ");
+            g_string_truncate(str, len);
+            d.str = str->str;
+
+            size = g_strdup_printf("%d", len);
+            run("measure string", size, "char", len, bench_measure, &d);
+            g_free(size);
+        }
+        g_string_free(str, TRUE);
+        RrFontClose(d.font);
+    }
+
+    RrInstanceFree(inst);
+    XCloseDisplay(display);
+    return 0;
+}
@@ -30,6 +30,7 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 struct fallbacks {
     RrAppearance *focused_disabled;
@@ -49,6 +50,7 @@ struct fallbacks {
 };
 
 static XrmDatabase loaddb(const gchar *name, gchar **path);
+static gchar *dir_stamp(const gchar *path);
 static gboolean read_int(XrmDatabase db, const gchar *rname, gint *value);
 static gboolean read_string(XrmDatabase db, const gchar *rname, gchar **value);
 static gboolean read_color(XrmDatabase db, const RrInstance *inst,
@@ -940,7 +942,8 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     theme->a_menu_bullet_selected->texture[0].data.mask.color =
         theme->menu_bullet_selected_color;
 
-    g_free(path);
+    theme->path = path;
+    theme->stamp = dir_stamp(path);
     XrmDestroyDatabase(db);
 
     /* set the font heights */
@@ -1007,6 +1010,8 @@ void RrThemeFree(RrTheme *theme)
 {
     if (theme) {
         g_free(theme->name);
+        g_free(theme->path);
+        g_free(theme->stamp);
 
         RrButtonFree(theme->btn_max);
         RrButtonFree(theme->btn_close);
@@ -1112,6 +1117,48 @@ void RrThemeFree(RrTheme *theme)
     }
 }
 
+/*! Returns a summary of the names, sizes and times of the files in the
+  directory, which will change if any of them are edited */
+static gchar *dir_stamp(const gchar *path)
+{
+    GChecksum *sum;
+    GDir *dir;
+    const gchar *name;
+    gchar *r;
+
+    sum = g_checksum_new(G_CHECKSUM_MD5);
+    if ((dir = g_dir_open(path, 0, NULL))) {
+        while ((name = g_dir_read_name(dir))) {
+            gchar *file, *s;
+            struct stat st;
+
+            file = g_build_filename(path, name, NULL);
+            if (stat(file, &st) == 0) {
+                s = g_strdup_printf("%s %ld %ld;", name,
+                                    (glong)st.st_mtime, (glong)st.st_size);
+                g_checksum_update(sum, (guchar*)s, -1);
+                g_free(s);
+            }
+            g_free(file);
+        }
+        g_dir_close(dir);
+    }
+    r = g_strdup(g_checksum_get_string(sum));
+    g_checksum_free(sum);
+    return r;
+}
+
+gboolean RrThemeChanged(const RrTheme *theme)
+{
+    gchar *stamp;
+    gboolean r;
+
+    stamp = dir_stamp(theme->path);
+    r = strcmp(stamp, theme->stamp) != 0;
+    g_free(stamp);
+    return r;
+}
+
 static XrmDatabase loaddb(const gchar *name, gchar **path)
 {
     GSList *it;
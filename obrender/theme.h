@@ -174,6 +174,10 @@ struct _RrTheme {
     RrAppearance *osd_focused_button;
 
     gchar *name;
+    /*! The directory the theme was loaded from */
+    gchar *path;
+    /*! Used to tell if the theme's files changed after it was loaded */
+    gchar *stamp;
 };
 
 /*! The font values are all optional. If a NULL is used for any of them, then
@@ -185,6 +189,10 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *theme,
                     RrFont *active_osd_font, RrFont *inactive_osd_font);
 void RrThemeFree(RrTheme *theme);
 
+/*! Returns TRUE if any of the theme's files have been changed since it was
+  loaded */
+gboolean RrThemeChanged(const RrTheme *theme);
+
 G_END_DECLS
 
 #endif
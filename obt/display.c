@@ -31,6 +31,13 @@
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#ifdef HAVE_STDLIB_H
+#  include <stdlib.h>
+#endif
+#ifdef USE_XCB
+#  include <X11/Xlib-xcb.h>
+#  include <xcb/xcb.h>
+#endif
 
 /* from xqueue.c */
 extern void xqueue_init(void);
@@ -163,3 +170,56 @@ void obt_display_ignore_errors(gboolean ignore)
     xerror_ignore = ignore;
     if (ignore) obt_display_error_occured = FALSE;
 }
+
+ObtAttributesCookie obt_display_request_attributes(Window win)
+{
+    ObtAttributesCookie c;
+
+    c.win = win;
+#ifdef USE_XCB
+    c.sequence =
+        xcb_get_window_attributes(XGetXCBConnection(obt_display),
+                                  win).sequence;
+#else
+    c.sequence = 0;
+#endif
+    return c;
+}
+
+gboolean obt_display_reply_attributes(ObtAttributesCookie *c,
+                                      gint *map_state,
+                                      gboolean *override_redirect)
+{
+#ifdef USE_XCB
+    xcb_get_window_attributes_cookie_t ck;
+    xcb_get_window_attributes_reply_t *rep;
+    xcb_generic_error_t *err = NULL;
+
+    ck.sequence = c->sequence;
+    rep = xcb_get_window_attributes_reply(XGetXCBConnection(obt_display),
+                                          ck, &err);
+    if (err) free(err);
+    if (!rep) return FALSE;
+
+    /* the map states have the same values in xcb and xlib */
+    *map_state = rep->map_state;
+    *override_redirect = rep->override_redirect;
+    free(rep);
+    return TRUE;
+#else
+    XWindowAttributes attrib;
+
+    if (!XGetWindowAttributes(obt_display, c->win, &attrib))
+        return FALSE;
+    *map_state = attrib.map_state;
+    *override_redirect = attrib.override_redirect;
+    return TRUE;
+#endif
+}
+
+void obt_display_discard_attributes(ObtAttributesCookie *c)
+{
+#ifdef USE_XCB
+    xcb_discard_reply(XGetXCBConnection(obt_display), c->sequence);
+#endif
+}
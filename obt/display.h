@@ -65,6 +65,23 @@ void     obt_display_ignore_errors(gboolean ignore);
 
 #define  obt_root(screen) (RootWindow(obt_display, screen))
 
+/*! A request for a window's attributes whose reply has not been waited for
+  yet, see ObtPropCookie */
+typedef struct _ObtAttributesCookie {
+    Window win;
+    guint sequence;
+} ObtAttributesCookie;
+
+ObtAttributesCookie obt_display_request_attributes(Window win);
+/*! Gets the attributes of the window which the window manager looks at before
+  managing it.  Returns FALSE if the window does not exist.
+  @param map_state One of IsUnmapped, IsUnviewable or IsViewable.
+*/
+gboolean obt_display_reply_attributes(ObtAttributesCookie *c,
+                                      gint *map_state,
+                                      gboolean *override_redirect);
+void obt_display_discard_attributes(ObtAttributesCookie *c);
+
 G_END_DECLS
 
 #endif /*__obt_display_h*/
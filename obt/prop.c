@@ -24,9 +24,32 @@
 #ifdef HAVE_STRING_H
 #  include <string.h>
 #endif
+#ifdef HAVE_STDLIB_H
+#  include <stdlib.h>
+#endif
+#ifdef USE_XCB
+#  include <X11/Xlib-xcb.h>
+#  include <xcb/xcb.h>
+#endif
+
+/*! A property's value as read from the server */
+typedef struct _PropValue {
+    Atom type;
+    gint size;
+    guint num;
+    /*! num items of size bits each, followed by a nul byte so text can be
+      used in place.  Free it with g_free(). */
+    guchar *data;
+} PropValue;
 
 Atom prop_atoms[OBT_PROP_NUM_ATOMS];
 gboolean prop_started = FALSE;
+static gulong prop_reads = 0;
+
+/*! The window whose properties were prefetched, and the cookies for them,
+  keyed by the property atom */
+static Window      prefetch_win = None;
+static GHashTable *prefetch = NULL;
 
 #define CREATE_NAME(var, name) (prop_atoms[OBT_PROP_##var] = \
                                 XInternAtom((obt_display), (name), FALSE))
@@ -200,6 +223,12 @@ void obt_prop_startup(void)
     CREATE_(OB_APP_GROUP_NAME);
     CREATE_(OB_APP_GROUP_CLASS);
     CREATE_(OB_APP_TYPE);
+    CREATE_(OB_METRICS);
+}
+
+gulong obt_prop_reads(void)
+{
+    return prop_reads;
 }
 
 Atom obt_prop_atom(ObtPropAtom a)
@@ -209,115 +238,220 @@ Atom obt_prop_atom(ObtPropAtom a)
     return prop_atoms[a];
 }
 
-static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
-                             guchar *data, gulong num)
+/*! Copies the items from the format Xlib returns them in, where 32-bit items
+  are longs, into a PropValue's data */
+static guchar* copy_items(const guchar *xdata, gint size, gulong num)
+{
+    guchar *data;
+    gulong i;
+
+    data = g_malloc(num * (size / 8) + 1);
+    for (i = 0; i < num; ++i)
+        switch (size) {
+        case 8:
+            data[i] = xdata[i];
+            break;
+        case 16:
+            ((guint16*)data)[i] = ((gushort*)xdata)[i];
+            break;
+        case 32:
+            ((guint32*)data)[i] = ((gulong*)xdata)[i];
+            break;
+        default:
+            g_assert_not_reached(); /* unhandled size */
+        }
+    data[num * (size / 8)] = '\0';
+    return data;
+}
+
+/*! Reads a property with a round trip to the server.  Returns FALSE if the
+  window does not have it, or it is not of @type. */
+static gboolean x_read(Window win, Atom prop, Atom type, glong len,
+                       PropValue *v)
 {
-    gboolean ret = FALSE;
     gint res;
     guchar *xdata = NULL;
-    Atom ret_type;
-    gint ret_size;
-    gulong ret_items, bytes_left;
-    glong num32 = 32 / size * num; /* num in 32-bit elements */
-
-    res = XGetWindowProperty(obt_display, win, prop, 0l, num32,
-                             FALSE, type, &ret_type, &ret_size,
-                             &ret_items, &bytes_left, &xdata);
-    if (res == Success && ret_items && xdata) {
-        if (ret_size == size && ret_items >= num) {
-            guint i;
-            for (i = 0; i < num; ++i)
-                switch (size) {
-                case 8:
-                    data[i] = xdata[i];
-                    break;
-                case 16:
-                    ((guint16*)data)[i] = ((gushort*)xdata)[i];
-                    break;
-                case 32:
-                    ((guint32*)data)[i] = ((gulong*)xdata)[i];
-                    break;
-                default:
-                    g_assert_not_reached(); /* unhandled size */
-                }
+    gulong num, bytes_left;
+    gboolean ret = FALSE;
+
+    ++prop_reads;
+    res = XGetWindowProperty(obt_display, win, prop, 0l, len,
+                             FALSE, type, &v->type, &v->size,
+                             &num, &bytes_left, &xdata);
+    if (res == Success) {
+        if (num > 0 && xdata &&
+            (v->size == 8 || v->size == 16 || v->size == 32))
+        {
+            v->num = num;
+            v->data = copy_items(xdata, v->size, num);
             ret = TRUE;
         }
-        XFree(xdata);
+        if (xdata) XFree(xdata);
     }
     return ret;
 }
 
-static gboolean get_all(Window win, Atom prop, Atom type, gint size,
-                        guchar **data, guint *num)
+/*! Waits for the reply to a property request */
+static gboolean reply_value(ObtPropCookie *c, PropValue *v)
 {
+#ifdef USE_XCB
+    xcb_get_property_cookie_t ck;
+    xcb_get_property_reply_t *rep;
+    xcb_generic_error_t *err = NULL;
     gboolean ret = FALSE;
-    gint res;
-    guchar *xdata = NULL;
-    Atom ret_type;
-    gint ret_size;
-    gulong ret_items, bytes_left;
 
-    res = XGetWindowProperty(obt_display, win, prop, 0l, G_MAXLONG,
-                             FALSE, type, &ret_type, &ret_size,
-                             &ret_items, &bytes_left, &xdata);
-    if (res == Success) {
-        if (ret_size == size && ret_items > 0) {
-            guint i;
-
-            *data = g_malloc(ret_items * (size / 8));
-            for (i = 0; i < ret_items; ++i)
-                switch (size) {
-                case 8:
-                    (*data)[i] = xdata[i];
-                    break;
-                case 16:
-                    ((guint16*)*data)[i] = ((gushort*)xdata)[i];
-                    break;
-                case 32:
-                    ((guint32*)*data)[i] = ((gulong*)xdata)[i];
-                    break;
-                default:
-                    g_assert_not_reached(); /* unhandled size */
-                }
-            *num = ret_items;
+    ck.sequence = c->sequence;
+    rep = xcb_get_property_reply(XGetXCBConnection(obt_display), ck, &err);
+    if (err) free(err);
+    if (!rep) return FALSE;
+
+    if (rep->value_len > 0 &&
+        (rep->format == 8 || rep->format == 16 || rep->format == 32))
+    {
+        const guint len = rep->value_len * (rep->format / 8);
+
+        v->type = rep->type;
+        v->size = rep->format;
+        v->num = rep->value_len;
+        /* xcb gives the items packed, as we want them */
+        v->data = g_malloc(len + 1);
+        memcpy(v->data, xcb_get_property_value(rep), len);
+        v->data[len] = '\0';
+        ret = TRUE;
+    }
+    free(rep);
+    return ret;
+#else
+    return x_read(c->win, c->prop, c->type, G_MAXLONG, v);
+#endif
+}
+
+/*! Removes a property from the prefetched ones, because it is being read or
+  it changed */
+static gboolean prefetch_take(Window win, Atom prop, ObtPropCookie *c)
+{
+    ObtPropCookie *p;
+
+    if (win != prefetch_win || !prefetch) return FALSE;
+    if (!(p = g_hash_table_lookup(prefetch, GUINT_TO_POINTER(prop))))
+        return FALSE;
+
+    /* steal it, as removing it would discard the reply the caller wants */
+    *c = *p;
+    g_hash_table_steal(prefetch, GUINT_TO_POINTER(prop));
+    g_slice_free(ObtPropCookie, p);
+    return TRUE;
+}
+
+static void prefetch_drop(Window win, Atom prop)
+{
+    ObtPropCookie c;
+
+    if (prefetch_take(win, prop, &c))
+        obt_prop_discard(&c);
+}
+
+/*! Reads a property, from its prefetched reply if there is one.  Only @len
+  32-bit units are needed, but more may be returned. */
+static gboolean read_value(Window win, Atom prop, Atom type, glong len,
+                           PropValue *v)
+{
+    ObtPropCookie c;
+
+    if (prefetch_take(win, prop, &c)) {
+        if (!reply_value(&c, v))
+            return FALSE;
+        /* it was read with any type, so check it here as the server would
+           have */
+        if (type != AnyPropertyType && v->type != type) {
+            g_free(v->data);
+            return FALSE;
+        }
+        return TRUE;
+    }
+    return x_read(win, prop, type, len, v);
+}
+
+static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
+                             guchar *data, gulong num)
+{
+    gboolean ret = FALSE;
+    PropValue v;
+
+    if (read_value(win, prop, type, 32 / size * num, &v)) {
+        if (v.size == size && v.num >= num) {
+            memcpy(data, v.data, num * (size / 8));
             ret = TRUE;
         }
-        XFree(xdata);
+        g_free(v.data);
     }
     return ret;
 }
 
-/*! Get a text property from a window, and fill out the XTextProperty with it.
-  @param win The window to read the property from.
-  @param prop The atom of the property to read off the window.
-  @param tprop The XTextProperty to fill out.
-  @param type 0 to get text of any type, or a value from
-    ObtPropTextType to restrict the value to a specific type.
-  @return TRUE if the text was read and validated against the @type, and FALSE
-    otherwise.
-*/
-static gboolean get_text_property(Window win, Atom prop,
-                                  XTextProperty *tprop, ObtPropTextType type)
+static gboolean get_all(Window win, Atom prop, Atom type, gint size,
+                        guchar **data, guint *num)
+{
+    PropValue v;
+
+    if (read_value(win, prop, type, G_MAXLONG, &v)) {
+        if (v.size == size) {
+            *data = v.data;
+            *num = v.num;
+            return TRUE;
+        }
+        g_free(v.data);
+    }
+    return FALSE;
+}
+
+static gboolean text_type_ok(Atom encoding, ObtPropTextType type)
 {
-    if (!(XGetTextProperty(obt_display, win, tprop, prop) && tprop->nitems))
-        return FALSE;
     if (!type)
         return TRUE; /* no type checking */
     switch (type) {
     case OBT_PROP_TEXT_STRING:
     case OBT_PROP_TEXT_STRING_XPCS:
     case OBT_PROP_TEXT_STRING_NO_CC:
-        return tprop->encoding == OBT_PROP_ATOM(STRING);
+        return encoding == OBT_PROP_ATOM(STRING);
     case OBT_PROP_TEXT_COMPOUND_TEXT:
-        return tprop->encoding == OBT_PROP_ATOM(COMPOUND_TEXT);
+        return encoding == OBT_PROP_ATOM(COMPOUND_TEXT);
     case OBT_PROP_TEXT_UTF8_STRING:
-        return tprop->encoding == OBT_PROP_ATOM(UTF8_STRING);
+        return encoding == OBT_PROP_ATOM(UTF8_STRING);
     default:
         g_assert_not_reached();
         return FALSE;
     }
 }
 
+static void value_to_text_property(PropValue *v, XTextProperty *tprop)
+{
+    tprop->value = v->data;
+    tprop->encoding = v->type;
+    tprop->format = v->size;
+    tprop->nitems = v->num;
+}
+
+/*! Get a text property from a window, and fill out the XTextProperty with it.
+  @param win The window to read the property from.
+  @param prop The atom of the property to read off the window.
+  @param tprop The XTextProperty to fill out.
+  @param type 0 to get text of any type, or a value from
+    ObtPropTextType to restrict the value to a specific type.
+  @return TRUE if the text was read and validated against the @type, and FALSE
+    otherwise.  The tprop's value must be freed with g_free() either way.
+*/
+static gboolean get_text_property(Window win, Atom prop,
+                                  XTextProperty *tprop, ObtPropTextType type)
+{
+    PropValue v;
+
+    tprop->value = NULL;
+    if (!read_value(win, prop, AnyPropertyType, G_MAXLONG, &v))
+        return FALSE;
+    value_to_text_property(&v, tprop);
+    return text_type_ok(tprop->encoding, type);
+}
+
 /*! Returns one or more UTF-8 encoded strings from the text property.
   @param tprop The XTextProperty to convert into UTF-8 string(s).
   @param type The type which specifies the format that the text must meet, or
@@ -496,7 +630,7 @@ gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
             ret = TRUE;
         }
     }
-    XFree(tprop.value);
+    g_free(tprop.value);
     return ret;
 }
 
@@ -516,12 +650,125 @@ gboolean obt_prop_get_array_text(Window win, Atom prop,
             ret = TRUE;
         }
     }
-    XFree(tprop.value);
+    g_free(tprop.value);
     return ret;
 }
 
+ObtPropCookie obt_prop_request(Window win, Atom prop, Atom type)
+{
+    ObtPropCookie c;
+
+    c.win = win;
+    c.prop = prop;
+    c.type = type;
+#ifdef USE_XCB
+    c.sequence = xcb_get_property(XGetXCBConnection(obt_display), FALSE,
+                                  win, prop, type, 0,
+                                  G_MAXUINT32 / 4).sequence;
+#else
+    c.sequence = 0;
+#endif
+    return c;
+}
+
+gboolean obt_prop_reply32(ObtPropCookie *c, guint32 *ret)
+{
+    PropValue v;
+    gboolean ok = FALSE;
+
+    if (reply_value(c, &v)) {
+        if (v.size == 32) {
+            *ret = ((guint32*)v.data)[0];
+            ok = TRUE;
+        }
+        g_free(v.data);
+    }
+    return ok;
+}
+
+gboolean obt_prop_reply_array32(ObtPropCookie *c, guint32 **ret, guint *nret)
+{
+    PropValue v;
+
+    if (reply_value(c, &v)) {
+        if (v.size == 32) {
+            *ret = (guint32*)v.data;
+            *nret = v.num;
+            return TRUE;
+        }
+        g_free(v.data);
+    }
+    return FALSE;
+}
+
+gboolean obt_prop_reply_text(ObtPropCookie *c, ObtPropTextType type,
+                             gchar **ret_string)
+{
+    PropValue v;
+    XTextProperty tprop;
+    gchar *str;
+    gboolean ret = FALSE;
+
+    if (reply_value(c, &v)) {
+        value_to_text_property(&v, &tprop);
+        if (text_type_ok(tprop.encoding, type) &&
+            (str = (gchar*)convert_text_property(&tprop, type, 1)))
+        {
+            *ret_string = str;
+            ret = TRUE;
+        }
+        g_free(v.data);
+    }
+    return ret;
+}
+
+void obt_prop_discard(ObtPropCookie *c)
+{
+#ifdef USE_XCB
+    xcb_discard_reply(XGetXCBConnection(obt_display), c->sequence);
+#endif
+}
+
+static void prefetch_free(gpointer c)
+{
+    ObtPropCookie *p = c;
+
+    obt_prop_discard(p);
+    g_slice_free(ObtPropCookie, p);
+}
+
+void obt_prop_prefetch(Window win, const Atom *props, guint num)
+{
+#ifdef USE_XCB
+    guint i;
+
+    g_assert(prefetch_win == None);
+
+    prefetch_win = win;
+    prefetch = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                     NULL, prefetch_free);
+    for (i = 0; i < num; ++i) {
+        ObtPropCookie *c = g_slice_new(ObtPropCookie);
+        *c = obt_prop_request(win, props[i], AnyPropertyType);
+        g_hash_table_insert(prefetch, GUINT_TO_POINTER(props[i]), c);
+    }
+    /* they are all answered with one round trip */
+    ++prop_reads;
+#endif
+}
+
+void obt_prop_prefetch_end(void)
+{
+    if (prefetch) {
+        g_hash_table_destroy(prefetch);
+        prefetch = NULL;
+    }
+    prefetch_win = None;
+}
+
 void obt_prop_set32(Window win, Atom prop, Atom type, gulong val)
 {
+    prefetch_drop(win, prop);
     XChangeProperty(obt_display, win, prop, type, 32, PropModeReplace,
                     (guchar*)&val, 1);
 }
@@ -529,12 +776,14 @@ void obt_prop_set32(Window win, Atom prop, Atom type, gulong val)
 void obt_prop_set_array32(Window win, Atom prop, Atom type, gulong *val,
                       guint num)
 {
+    prefetch_drop(win, prop);
     XChangeProperty(obt_display, win, prop, type, 32, PropModeReplace,
                     (guchar*)val, num);
 }
 
 void obt_prop_set_text(Window win, Atom prop, const gchar *val)
 {
+    prefetch_drop(win, prop);
     XChangeProperty(obt_display, win, prop, OBT_PROP_ATOM(UTF8_STRING), 8,
                     PropModeReplace, (const guchar*)val, strlen(val));
 }
@@ -544,6 +793,8 @@ void obt_prop_set_array_text(Window win, Atom prop, const gchar *const *strs)
     GString *str;
     gchar const *const *s;
 
+    prefetch_drop(win, prop);
+
     str = g_string_sized_new(0);
     for (s = strs; *s; ++s) {
         str = g_string_append(str, *s);
@@ -556,6 +807,7 @@ void obt_prop_set_array_text(Window win, Atom prop, const gchar *const *strs)
 
 void obt_prop_erase(Window win, Atom prop)
 {
+    prefetch_drop(win, prop);
     XDeleteProperty(obt_display, win, prop);
 }
 
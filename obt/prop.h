@@ -222,12 +222,17 @@ typedef enum {
     OBT_PROP_OB_APP_GROUP_NAME,
     OBT_PROP_OB_APP_GROUP_CLASS,
     OBT_PROP_OB_APP_TYPE,
+    OBT_PROP_OB_METRICS,
 
     OBT_PROP_NUM_ATOMS
 } ObtPropAtom;
 
 Atom obt_prop_atom(ObtPropAtom a);
 
+/*! Returns how many properties have been read from the server, each of which
+  is a round trip */
+gulong obt_prop_reads(void);
+
 typedef enum {
     /*! STRING is latin1 encoded.  It cannot contain control characters except
        for tab and line-feed. */
@@ -256,6 +261,39 @@ gboolean obt_prop_get_array_text(Window win, Atom prop,
                                  ObtPropTextType type,
                                  gchar ***ret);
 
+/*! A property read that has been sent to the server but whose reply has not
+  been waited for yet.  Many can be sent before waiting for any of them, so
+  they all cost one round trip together instead of one each.  Without XCB
+  the property is read when its reply is asked for. */
+typedef struct _ObtPropCookie {
+    Window win;
+    Atom prop;
+    Atom type;
+    guint sequence;
+} ObtPropCookie;
+
+/*! Sends a request for a property, use AnyPropertyType to allow any type.
+  Every cookie returned must be passed to one of the obt_prop_reply*
+  functions or to obt_prop_discard. */
+ObtPropCookie obt_prop_request(Window win, Atom prop, Atom type);
+gboolean obt_prop_reply32(ObtPropCookie *c, guint32 *ret);
+/*! The items are returned as they are stored on the window, no matter what
+  size they are, and must be freed with g_free() */
+gboolean obt_prop_reply_array32(ObtPropCookie *c, guint32 **ret,
+                                guint *nret);
+gboolean obt_prop_reply_text(ObtPropCookie *c, ObtPropTextType type,
+                             gchar **ret);
+/*! Throws away the reply to a request without waiting for it */
+void obt_prop_discard(ObtPropCookie *c);
+
+/*! Requests all of the properties at once, and the obt_prop_get* functions
+  will use the replies for them until obt_prop_prefetch_end is called.
+  Setting or erasing one of the properties drops its reply.  This does nothing
+  without XCB. */
+void obt_prop_prefetch(Window win, const Atom *props, guint num);
+/*! Throws away the replies that were prefetched and not used */
+void obt_prop_prefetch_end(void);
+
 void obt_prop_set32(Window win, Atom prop, Atom type, gulong val);
 void obt_prop_set_array32(Window win, Atom prop, Atom type, gulong *val,
                           guint num);
@@ -278,6 +316,9 @@ void obt_prop_message_to(Window to, Window about, Atom messagetype,
 #define OBT_PROP_GETA32(win, prop, type, ret, nret) \
     (obt_prop_get_array32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), \
                           ret, nret))
+#define OBT_PROP_REQUEST(win, prop, type) \
+    (obt_prop_request(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type)))
+
 #define OBT_PROP_GETS(win, prop, ret) \
     (obt_prop_get_text(win, OBT_PROP_ATOM(prop), 0, ret))
 #define OBT_PROP_GETSS(win, prop, ret) \
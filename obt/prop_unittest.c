@@ -0,0 +1,126 @@
+#include "obt/unittest_base.h"
+
+#include "obt/display.h"
+#include "obt/prop.h"
+
+#include <glib.h>
+#include <string.h>
+
+static Window make_window(void)
+{
+    XSetWindowAttributes attrib;
+
+    attrib.override_redirect = TRUE;
+    return XCreateWindow(obt_display, obt_root(DefaultScreen(obt_display)),
+                         0, 0, 1, 1, 0, CopyFromParent, InputOutput,
+                         CopyFromParent, CWOverrideRedirect, &attrib);
+}
+
+static void prefetched() {
+    TEST_START();
+
+    Window w = make_window();
+    Atom props[2];
+    guint32 desktop = 0;
+    gchar *name = NULL;
+
+    OBT_PROP_SET32(w, NET_WM_DESKTOP, CARDINAL, 3);
+    OBT_PROP_SETS(w, NET_WM_NAME, "prefetched");
+    XSync(obt_display, FALSE);
+
+    props[0] = OBT_PROP_ATOM(NET_WM_DESKTOP);
+    props[1] = OBT_PROP_ATOM(NET_WM_NAME);
+    obt_prop_prefetch(w, props, 2);
+
+    /* the values come from the prefetched replies */
+    EXPECT_BOOL_EQ(TRUE, OBT_PROP_GET32(w, NET_WM_DESKTOP, CARDINAL,
+                                        &desktop));
+    EXPECT_UINT_EQ(3, desktop);
+    EXPECT_BOOL_EQ(TRUE, OBT_PROP_GETS_UTF8(w, NET_WM_NAME, &name));
+    EXPECT_BOOL_EQ(TRUE, name && !strcmp(name, "prefetched"));
+    g_free(name);
+
+    /* and again once they have been used */
+    desktop = 0;
+    EXPECT_BOOL_EQ(TRUE, OBT_PROP_GET32(w, NET_WM_DESKTOP, CARDINAL,
+                                        &desktop));
+    EXPECT_UINT_EQ(3, desktop);
+
+    obt_prop_prefetch_end();
+    XDestroyWindow(obt_display, w);
+
+    TEST_END();
+}
+
+static void prefetched_then_set() {
+    TEST_START();
+
+    Window w = make_window();
+    Atom props[1];
+    guint32 desktop = 0;
+
+    OBT_PROP_SET32(w, NET_WM_DESKTOP, CARDINAL, 3);
+    XSync(obt_display, FALSE);
+
+    props[0] = OBT_PROP_ATOM(NET_WM_DESKTOP);
+    obt_prop_prefetch(w, props, 1);
+
+    /* setting it drops the prefetched value */
+    OBT_PROP_SET32(w, NET_WM_DESKTOP, CARDINAL, 5);
+    EXPECT_BOOL_EQ(TRUE, OBT_PROP_GET32(w, NET_WM_DESKTOP, CARDINAL,
+                                        &desktop));
+    EXPECT_UINT_EQ(5, desktop);
+
+    obt_prop_prefetch_end();
+    XDestroyWindow(obt_display, w);
+
+    TEST_END();
+}
+
+static void requested() {
+    TEST_START();
+
+    Window w = make_window();
+    ObtPropCookie c1, c2;
+    guint32 *data = NULL;
+    guint n = 0;
+    gulong val[3] = { 1, 2, 3 };
+
+    OBT_PROP_SETA32(w, NET_WM_STRUT, CARDINAL, val, 3);
+    XSync(obt_display, FALSE);
+
+    c1 = OBT_PROP_REQUEST(w, NET_WM_STRUT, CARDINAL);
+    c2 = OBT_PROP_REQUEST(w, NET_WM_STRUT_PARTIAL, CARDINAL);
+
+    EXPECT_BOOL_EQ(TRUE, obt_prop_reply_array32(&c1, &data, &n));
+    EXPECT_UINT_EQ(3, n);
+    EXPECT_BOOL_EQ(TRUE, data && data[0] == 1 && data[1] == 2 &&
+                   data[2] == 3);
+    g_free(data);
+
+    /* it was never set */
+    EXPECT_BOOL_EQ(FALSE, obt_prop_reply_array32(&c2, &data, &n));
+
+    XDestroyWindow(obt_display, w);
+
+    TEST_END();
+}
+
+void run_prop_unittest() {
+    unittest_start_suite("prop");
+
+    /* the properties are read from a real X server */
+    if (!obt_display_open(NULL)) {
+        printf("[ SKIP   ] no X display to test with\n");
+        unittest_end_suite();
+        return;
+    }
+
+    prefetched();
+    prefetched_then_set();
+    requested();
+
+    obt_display_close();
+
+    unittest_end_suite();
+}
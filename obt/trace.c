@@ -0,0 +1,109 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/trace.c for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "obt/trace.h"
+
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+
+typedef struct _ObtTraceRecord {
+    const gchar *name;
+    gint64 usec;
+    gchar phase;
+} ObtTraceRecord;
+
+gboolean obt_trace_on = FALSE;
+
+static ObtTraceRecord *ring = NULL;
+static guint           ring_size;
+/*! Where the next record goes */
+static guint           ring_pos;
+/*! TRUE once ring_pos has wrapped around, so the whole ring is in use */
+static gboolean        ring_full;
+
+void obt_trace_start(guint size)
+{
+    g_return_if_fail(size > 0);
+
+    obt_trace_stop();
+
+    ring = g_new0(ObtTraceRecord, size);
+    ring_size = size;
+    ring_pos = 0;
+    ring_full = FALSE;
+    obt_trace_on = TRUE;
+}
+
+void obt_trace_stop(void)
+{
+    obt_trace_on = FALSE;
+    g_free(ring);
+    ring = NULL;
+}
+
+void obt_trace_record(const gchar *name, gchar phase)
+{
+    ObtTraceRecord *r = &ring[ring_pos];
+
+    r->name = name;
+    r->usec = g_get_monotonic_time();
+    r->phase = phase;
+
+    if (++ring_pos == ring_size) {
+        ring_pos = 0;
+        ring_full = TRUE;
+    }
+}
+
+gboolean obt_trace_dump(const gchar *path, GError **error)
+{
+    GString *str;
+    guint i, n, first;
+    gint depth;
+    gboolean ok;
+    const gint pid = getpid();
+
+    g_return_val_if_fail(ring != NULL, FALSE);
+
+    n = ring_full ? ring_size : ring_pos;
+    first = ring_full ? ring_pos : 0;
+
+    str = g_string_new("{\"traceEvents\":[");
+    depth = 0;
+    for (i = 0; i < n; ++i) {
+        const ObtTraceRecord *r = &ring[(first + i) % ring_size];
+
+        /* the oldest records may end spans whose start was overwritten,
+           viewers do not cope with those so leave them out */
+        if (r->phase == 'E' && depth == 0) continue;
+        depth += r->phase == 'B' ? 1 : -1;
+
+        g_string_append_printf(str,
+                               "%s\n{\"name\":\"%s\",\"cat\":\"openbox\","
+                               "\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT ","
+                               "\"pid\":%d,\"tid\":1}",
+                               (str->str[str->len-1] == '[' ? "" : ","),
+                               r->name, r->phase, r->usec, pid);
+    }
+    g_string_append(str, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    ok = g_file_set_contents(path, str->str, str->len, error);
+    g_string_free(str, TRUE);
+    return ok;
+}
@@ -0,0 +1,59 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/trace.h for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __obt_trace_h
+#define __obt_trace_h
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*! TRUE while spans are being recorded.  Only read it through the macros
+  below. */
+extern gboolean obt_trace_on;
+
+/*! Marks the start of a span.  The name must be a string constant, only the
+  pointer is kept. */
+#define OBT_TRACE_BEGIN(name) \
+    G_STMT_START { \
+        if (G_UNLIKELY(obt_trace_on)) obt_trace_record((name), 'B'); \
+    } G_STMT_END
+
+/*! Marks the end of the innermost span started with the same name */
+#define OBT_TRACE_END(name) \
+    G_STMT_START { \
+        if (G_UNLIKELY(obt_trace_on)) obt_trace_record((name), 'E'); \
+    } G_STMT_END
+
+/*! Starts recording into a ring buffer that keeps the last @size span
+  boundaries, older ones are overwritten */
+void obt_trace_start(guint size);
+/*! Stops recording and frees the ring buffer */
+void obt_trace_stop(void);
+
+/*! Writes the recorded spans, oldest first, to @path in the Chrome trace
+  event format, which chrome://tracing and Perfetto can open.  Recording
+  continues afterwards.
+  @return FALSE and sets @error if the file could not be written */
+gboolean obt_trace_dump(const gchar *path, GError **error);
+
+void obt_trace_record(const gchar *name, gchar phase);
+
+G_END_DECLS
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "obt/xml.h"
 #include "obt/paths.h"
+#include "obt/xmlcache.h"
 
 #include <libxml/xinclude.h>
 #include <glib.h>
@@ -51,6 +52,12 @@ struct _ObtXmlInst {
     gchar *last_error_file;
     gint last_error_line;
     gchar *last_error_message;
+    gboolean cache;
+};
+
+struct _ObtXmlPush {
+    xmlParserCtxtPtr ctxt;
+    gboolean failed;
 };
 
 static void obt_xml_save_last_error(ObtXmlInst* inst);
@@ -74,6 +81,7 @@ ObtXmlInst* obt_xml_instance_new(void)
     i->last_error_file = NULL;
     i->last_error_line = -1;
     i->last_error_message = NULL;
+    i->cache = FALSE;
     return i;
 }
 
@@ -93,6 +101,11 @@ void obt_xml_instance_unref(ObtXmlInst *i)
     }
 }
 
+void obt_xml_instance_set_cache(ObtXmlInst *i, gboolean cache)
+{
+    i->cache = cache;
+}
+
 xmlDocPtr obt_xml_doc(ObtXmlInst *i)
 {
     g_assert(i->doc); /* a doc is open? */
@@ -135,11 +148,16 @@ static gboolean load_file(ObtXmlInst *i,
 {
     GSList *it;
     gboolean r = FALSE;
+    gchar *cache_dir = NULL;
 
     g_assert(i->doc == NULL); /* another doc isn't open already? */
 
     xmlResetLastError();
 
+    if (i->cache)
+        cache_dir = g_build_filename(obt_paths_cache_home(i->xdg_paths),
+                                     "openbox", "xml", NULL);
+
     for (it = paths; !r && it; it = g_slist_next(it)) {
         gchar *path;
         struct stat s;
@@ -150,12 +168,20 @@ static gboolean load_file(ObtXmlInst *i,
             path = g_build_filename(it->data, domain, filename, NULL);
 
         if (stat(path, &s) >= 0) {
-            /* XML_PARSE_BLANKS is needed apparently, or the tree can end up
-               with extra nodes in it. */
-            i->doc = xmlReadFile(path, NULL, (XML_PARSE_NOBLANKS |
-                                              XML_PARSE_RECOVER));
-            xmlXIncludeProcessFlags(i->doc, (XML_PARSE_NOBLANKS |
-                                             XML_PARSE_RECOVER));
+            if (cache_dir)
+                i->doc = obt_xml_cache_load(cache_dir, path);
+            if (!i->doc) {
+                /* XML_PARSE_BLANKS is needed apparently, or the tree can end
+                   up with extra nodes in it. */
+                i->doc = xmlReadFile(path, NULL, (XML_PARSE_NOBLANKS |
+                                                  XML_PARSE_RECOVER));
+                xmlXIncludeProcessFlags(i->doc, (XML_PARSE_NOBLANKS |
+                                                 XML_PARSE_RECOVER));
+                /* don't keep a copy of a broken file, so the errors are
+                   shown again each time it is loaded */
+                if (cache_dir && i->doc && !xmlGetLastError())
+                    obt_xml_cache_save(cache_dir, path, i->doc);
+            }
             if (i->doc) {
                 i->root = xmlDocGetRootElement(i->doc);
                 if (!i->root) {
@@ -181,6 +207,8 @@ static gboolean load_file(ObtXmlInst *i,
         g_free(path);
     }
 
+    g_free(cache_dir);
+
     obt_xml_save_last_error(i);
 
     return r;
@@ -304,6 +332,75 @@ gboolean obt_xml_load_mem(ObtXmlInst *i,
     return r;
 }
 
+ObtXmlPush* obt_xml_push_new(void)
+{
+    ObtXmlPush *p = g_slice_new(ObtXmlPush);
+    p->ctxt = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, NULL);
+    p->failed = (p->ctxt == NULL);
+    return p;
+}
+
+void obt_xml_push_free(ObtXmlPush *p)
+{
+    if (p) {
+        if (p->ctxt) {
+            if (p->ctxt->myDoc)
+                xmlFreeDoc(p->ctxt->myDoc);
+            xmlFreeParserCtxt(p->ctxt);
+        }
+        g_slice_free(ObtXmlPush, p);
+    }
+}
+
+gboolean obt_xml_push_data(ObtXmlPush *p, const gchar *data, guint len)
+{
+    if (!p->failed && xmlParseChunk(p->ctxt, data, len, 0) != 0)
+        p->failed = TRUE;
+    return !p->failed;
+}
+
+gboolean obt_xml_load_push(ObtXmlInst *i, ObtXmlPush *p,
+                           const gchar *root_node)
+{
+    gboolean r = FALSE;
+
+    g_assert(i->doc == NULL); /* another doc isn't open already? */
+
+    xmlResetLastError();
+
+    /* tell the parser that it has seen the end of the document */
+    if (!p->failed && xmlParseChunk(p->ctxt, NULL, 0, 1) != 0)
+        p->failed = TRUE;
+
+    if (!p->failed && p->ctxt->wellFormed) {
+        /* take the document from the parser */
+        i->doc = p->ctxt->myDoc;
+        p->ctxt->myDoc = NULL;
+    }
+
+    if (i->doc) {
+        i->root = xmlDocGetRootElement(i->doc);
+        if (!i->root) {
+            xmlFreeDoc(i->doc);
+            i->doc = NULL;
+            g_message("Given data is an empty document");
+        }
+        else if (xmlStrcmp(i->root->name, (const xmlChar*)root_node)) {
+            xmlFreeDoc(i->doc);
+            i->doc = NULL;
+            i->root = NULL;
+            g_message("XML Document in given data is of wrong "
+                      "type. Root node is not '%s'\n", root_node);
+        }
+        else
+            r = TRUE; /* ok ! */
+    }
+
+    obt_xml_save_last_error(i);
+
+    return r;
+}
+
 static void obt_xml_save_last_error(ObtXmlInst* inst)
 {
     xmlErrorPtr error = xmlGetLastError();
@@ -405,6 +502,14 @@ gint obt_xml_node_int(xmlNodePtr node)
     return i;
 }
 
+void obt_xml_checksum_node(GChecksum *sum, xmlNodePtr node)
+{
+    xmlBufferPtr b = xmlBufferCreate();
+    xmlNodeDump(b, node->doc, node, 0, 0);
+    g_checksum_update(sum, xmlBufferContent(b), xmlBufferLength(b));
+    xmlBufferFree(b);
+}
+
 gboolean obt_xml_node_bool(xmlNodePtr node)
 {
     xmlChar *c = xmlNodeGetContent(node);
@@ -25,6 +25,7 @@
 G_BEGIN_DECLS
 
 typedef struct _ObtXmlInst ObtXmlInst;
+typedef struct _ObtXmlPush ObtXmlPush;
 
 typedef void (*ObtXmlCallback)(xmlNodePtr node, gpointer data);
 
@@ -32,6 +33,11 @@ ObtXmlInst* obt_xml_instance_new(void);
 void obt_xml_instance_ref(ObtXmlInst *inst);
 void obt_xml_instance_unref(ObtXmlInst *inst);
 
+/*! Keep a binary copy of the files loaded by the instance in the user's
+  cache directory, and load them from there while they are unchanged, to
+  avoid parsing the XML again.  Off by default. */
+void obt_xml_instance_set_cache(ObtXmlInst *inst, gboolean cache);
+
 gboolean obt_xml_load_file(ObtXmlInst *inst,
                            const gchar *path,
                            const gchar *root_node);
@@ -51,6 +57,19 @@ gboolean obt_xml_load_theme_file(ObtXmlInst *inst,
 gboolean obt_xml_load_mem(ObtXmlInst *inst,
                           gpointer data, guint len, const gchar *root_node);
 
+/*! Create a parser for a document which arrives in pieces, such as the output
+  of another process.  Each piece is parsed as soon as it is given to
+  obt_xml_push_data. */
+ObtXmlPush* obt_xml_push_new(void);
+void obt_xml_push_free(ObtXmlPush *push);
+/*! Returns FALSE if the document is not well-formed, and further data would be
+  ignored. */
+gboolean obt_xml_push_data(ObtXmlPush *push, const gchar *data, guint len);
+/*! Finish parsing the document in the push parser, and open it in the
+  instance, the same as the other load functions. */
+gboolean obt_xml_load_push(ObtXmlInst *inst, ObtXmlPush *push,
+                           const gchar *root_node);
+
 /* Returns true if an error is present. */
 gboolean obt_xml_last_error(ObtXmlInst *inst);
 gchar* obt_xml_last_error_file(ObtXmlInst *inst);
@@ -72,6 +91,10 @@ void obt_xml_unregister(ObtXmlInst *inst, const gchar *tag);
 void obt_xml_tree(ObtXmlInst *i, xmlNodePtr node);
 void obt_xml_tree_from_root(ObtXmlInst *i);
 
+/*! Adds the node and everything inside it to the checksum, so that two trees
+  can be compared without keeping a copy of one of them */
+void obt_xml_checksum_node(GChecksum *sum, xmlNodePtr node);
+
 
 /* helpers */
 
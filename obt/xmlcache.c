@@ -0,0 +1,417 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/xmlcache.c for the Openbox window manager
+   Copyright (c) 2003-2007   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "obt/xmlcache.h"
+#include "obt/paths.h"
+
+#include <libxml/uri.h>
+#include <glib.h>
+
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+#endif
+
+/* The cache file is written in the machine's byte order, since it is never
+   shared between machines.  It holds:
+
+     the magic string
+     guint32 number of files
+       for each file: string path, gint64 mtime, gint64 size, string sha1
+     the root node
+
+   and each node is:
+
+     guint8 kind
+       NODE_ELEMENT: string name, guint32 number of attributes,
+                     (string name, string value) for each attribute,
+                     guint32 number of children, the child nodes
+       NODE_TEXT:    string content
+
+   where a string is a guint32 length followed by that many bytes and a nul,
+   so strings can be used straight from the mapped file.
+*/
+
+#define CACHE_MAGIC "OBXMLC\0\1"
+#define CACHE_MAGIC_LEN 8
+
+/* deeper than any sane config file, but keeps a corrupt file from recursing
+   forever */
+#define MAX_DEPTH 256
+
+typedef enum {
+    NODE_ELEMENT = 1,
+    NODE_TEXT = 2
+} NodeKind;
+
+typedef struct _Reader {
+    const gchar *p;
+    const gchar *end;
+} Reader;
+
+static gchar* cache_file_name(const gchar *cache_dir, const gchar *path)
+{
+    gchar *sum, *name, *file;
+
+    sum = g_compute_checksum_for_string(G_CHECKSUM_MD5, path, -1);
+    name = g_strconcat(sum, ".bin", NULL);
+    file = g_build_filename(cache_dir, name, NULL);
+    g_free(name);
+    g_free(sum);
+    return file;
+}
+
+static gchar* file_sha1(const gchar *path)
+{
+    gchar *contents, *sum;
+    gsize len;
+
+    if (!g_file_get_contents(path, &contents, &len, NULL))
+        return NULL;
+    sum = g_compute_checksum_for_data(G_CHECKSUM_SHA1, (guchar*)contents, len);
+    g_free(contents);
+    return sum;
+}
+
+static gboolean read_bytes(Reader *r, gpointer out, gsize len)
+{
+    if ((gsize)(r->end - r->p) < len)
+        return FALSE;
+    memcpy(out, r->p, len);
+    r->p += len;
+    return TRUE;
+}
+
+static gboolean read_u32(Reader *r, guint32 *v)
+{
+    return read_bytes(r, v, sizeof(guint32));
+}
+
+static gboolean read_i64(Reader *r, gint64 *v)
+{
+    return read_bytes(r, v, sizeof(gint64));
+}
+
+/*! Returns a pointer to the nul-terminated string in the file */
+static const gchar* read_string(Reader *r, guint32 *len)
+{
+    const gchar *s;
+
+    if (!read_u32(r, len) || (gsize)(r->end - r->p) < (gsize)*len + 1)
+        return NULL;
+    s = r->p;
+    if (s[*len] != '\0')
+        return NULL;
+    r->p += *len + 1;
+    return s;
+}
+
+static void write_u32(GByteArray *b, guint32 v)
+{
+    g_byte_array_append(b, (guint8*)&v, sizeof(v));
+}
+
+static void write_i64(GByteArray *b, gint64 v)
+{
+    g_byte_array_append(b, (guint8*)&v, sizeof(v));
+}
+
+static void write_string(GByteArray *b, const gchar *s)
+{
+    guint32 len = strlen(s);
+
+    write_u32(b, len);
+    g_byte_array_append(b, (const guint8*)s, len + 1);
+}
+
+/*! Checks that the files the cache was made from haven't changed since.
+  The contents are always hashed, as a file can be changed without its time
+  changing when it is written twice within the time's resolution.  Sets
+  @restamp if a file's contents are the same but its time is not, so the
+  cache is saved again with the new time. */
+static gboolean read_files(Reader *r, gboolean *restamp)
+{
+    guint32 i, n, len;
+
+    *restamp = FALSE;
+
+    if (!read_u32(r, &n))
+        return FALSE;
+    for (i = 0; i < n; ++i) {
+        const gchar *path, *sha1;
+        gint64 mtime, size;
+        struct stat s;
+        gchar *now;
+        gboolean same;
+
+        if (!(path = read_string(r, &len)) ||
+            !read_i64(r, &mtime) ||
+            !read_i64(r, &size) ||
+            !(sha1 = read_string(r, &len)))
+        {
+            return FALSE;
+        }
+
+        if (stat(path, &s) < 0 || (gint64)s.st_size != size)
+            return FALSE;
+
+        now = file_sha1(path);
+        same = now && !strcmp(now, sha1);
+        g_free(now);
+        if (!same)
+            return FALSE;
+        if ((gint64)s.st_mtime != mtime)
+            *restamp = TRUE;
+    }
+    return TRUE;
+}
+
+static xmlNodePtr read_node(Reader *r, xmlDocPtr doc, guint depth)
+{
+    guint8 kind;
+    guint32 i, n, len;
+    const gchar *s;
+    xmlNodePtr node;
+
+    if (depth > MAX_DEPTH || !read_bytes(r, &kind, 1))
+        return NULL;
+
+    switch (kind) {
+    case NODE_TEXT:
+        if (!(s = read_string(r, &len)))
+            return NULL;
+        return xmlNewDocTextLen(doc, (const xmlChar*)s, len);
+    case NODE_ELEMENT:
+        if (!(s = read_string(r, &len)))
+            return NULL;
+        node = xmlNewDocNode(doc, NULL, (const xmlChar*)s, NULL);
+
+        if (!read_u32(r, &n))
+            goto read_node_fail;
+        for (i = 0; i < n; ++i) {
+            const gchar *name, *value;
+
+            if (!(name = read_string(r, &len)) ||
+                !(value = read_string(r, &len)))
+            {
+                goto read_node_fail;
+            }
+            xmlNewProp(node, (const xmlChar*)name, (const xmlChar*)value);
+        }
+
+        if (!read_u32(r, &n))
+            goto read_node_fail;
+        for (i = 0; i < n; ++i) {
+            xmlNodePtr c = read_node(r, doc, depth + 1);
+            if (!c)
+                goto read_node_fail;
+            xmlAddChild(node, c);
+        }
+        return node;
+    default:
+        return NULL;
+    }
+
+read_node_fail:
+    xmlFreeNode(node);
+    return NULL;
+}
+
+xmlDocPtr obt_xml_cache_load(const gchar *cache_dir, const gchar *path)
+{
+    gchar *file;
+    GMappedFile *map;
+    Reader r;
+    xmlDocPtr doc = NULL;
+    xmlNodePtr root;
+    gboolean restamp;
+
+    file = cache_file_name(cache_dir, path);
+    map = g_mapped_file_new(file, FALSE, NULL);
+    g_free(file);
+    if (!map)
+        return NULL;
+
+    r.p = g_mapped_file_get_contents(map);
+    r.end = r.p + g_mapped_file_get_length(map);
+
+    if ((gsize)(r.end - r.p) >= CACHE_MAGIC_LEN &&
+        !memcmp(r.p, CACHE_MAGIC, CACHE_MAGIC_LEN))
+    {
+        r.p += CACHE_MAGIC_LEN;
+
+        if (read_files(&r, &restamp)) {
+            doc = xmlNewDoc((const xmlChar*)"1.0");
+            doc->URL = xmlStrdup((const xmlChar*)path);
+
+            if ((root = read_node(&r, doc, 0)) && r.p == r.end)
+                xmlDocSetRootElement(doc, root);
+            else {
+                if (root) xmlFreeNode(root);
+                xmlFreeDoc(doc);
+                doc = NULL;
+            }
+        }
+    }
+
+    g_mapped_file_unref(map);
+
+    if (doc && restamp)
+        obt_xml_cache_save(cache_dir, path, doc);
+
+    return doc;
+}
+
+/*! Returns FALSE if the node can't be stored faithfully in the cache */
+static gboolean write_node(GByteArray *b, xmlDocPtr doc, xmlNodePtr node,
+                           guint depth)
+{
+    xmlNodePtr c;
+    xmlAttrPtr a;
+    guint32 n;
+
+    if (depth > MAX_DEPTH)
+        return FALSE;
+
+    switch (node->type) {
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+        g_byte_array_append(b, (const guint8*)"\2", 1); /* NODE_TEXT */
+        write_string(b, node->content ? (gchar*)node->content : "");
+        return TRUE;
+    case XML_ELEMENT_NODE:
+        g_byte_array_append(b, (const guint8*)"\1", 1); /* NODE_ELEMENT */
+        write_string(b, (const gchar*)node->name);
+
+        /* attributes in a namespace (like the xml:base from an XInclude)
+           are left out */
+        for (n = 0, a = node->properties; a; a = a->next)
+            if (!a->ns) ++n;
+        write_u32(b, n);
+        for (a = node->properties; a; a = a->next) {
+            xmlChar *v;
+
+            if (a->ns) continue;
+            v = xmlNodeListGetString(doc, a->children, 1);
+            write_string(b, (const gchar*)a->name);
+            write_string(b, v ? (const gchar*)v : "");
+            xmlFree(v);
+        }
+
+        /* comments and XInclude markers are left out, the included content
+           is found between the markers */
+        for (n = 0, c = node->children; c; c = c->next)
+            if (c->type == XML_ELEMENT_NODE || c->type == XML_TEXT_NODE ||
+                c->type == XML_CDATA_SECTION_NODE)
+                ++n;
+            else if (c->type == XML_ENTITY_REF_NODE)
+                return FALSE;
+        write_u32(b, n);
+        for (c = node->children; c; c = c->next)
+            if (c->type == XML_ELEMENT_NODE || c->type == XML_TEXT_NODE ||
+                c->type == XML_CDATA_SECTION_NODE)
+            {
+                if (!write_node(b, doc, c, depth + 1))
+                    return FALSE;
+            }
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/*! Find the files that were XIncluded into the document */
+static void find_includes(xmlDocPtr doc, xmlNodePtr node, GSList **files)
+{
+    for (; node; node = node->next) {
+        if (node->type == XML_XINCLUDE_START) {
+            xmlChar *href = xmlGetProp(node, (const xmlChar*)"href");
+            xmlChar *base = xmlNodeGetBase(doc, node);
+            xmlChar *uri = NULL;
+
+            if (href)
+                uri = xmlBuildURI(href, base ? base : doc->URL);
+            if (uri) {
+                gchar *f = g_filename_from_uri((gchar*)uri, NULL, NULL);
+                if (!f && g_path_is_absolute((gchar*)uri))
+                    f = g_strdup((gchar*)uri);
+                if (f)
+                    *files = g_slist_append(*files, f);
+            }
+            xmlFree(uri);
+            xmlFree(base);
+            xmlFree(href);
+        }
+        else if (node->type == XML_ELEMENT_NODE)
+            find_includes(doc, node->children, files);
+    }
+}
+
+void obt_xml_cache_save(const gchar *cache_dir, const gchar *path,
+                        xmlDocPtr doc)
+{
+    GByteArray *b;
+    GSList *files, *it;
+    xmlNodePtr root;
+    gboolean ok = TRUE;
+
+    if (!(root = xmlDocGetRootElement(doc)))
+        return;
+
+    files = g_slist_prepend(NULL, g_strdup(path));
+    find_includes(doc, root, &files);
+
+    b = g_byte_array_new();
+    g_byte_array_append(b, (const guint8*)CACHE_MAGIC, CACHE_MAGIC_LEN);
+
+    write_u32(b, g_slist_length(files));
+    for (it = files; ok && it; it = g_slist_next(it)) {
+        struct stat s;
+        gchar *sha1;
+
+        if (stat(it->data, &s) < 0 || !(sha1 = file_sha1(it->data)))
+            ok = FALSE;
+        else {
+            write_string(b, it->data);
+            write_i64(b, s.st_mtime);
+            write_i64(b, s.st_size);
+            write_string(b, sha1);
+            g_free(sha1);
+        }
+    }
+
+    if (ok)
+        ok = write_node(b, doc, root, 0);
+
+    if (ok && obt_paths_mkdir_path(cache_dir, 0700)) {
+        gchar *file = cache_file_name(cache_dir, path);
+        g_file_set_contents(file, (gchar*)b->data, b->len, NULL);
+        g_free(file);
+    }
+
+    g_byte_array_free(b, TRUE);
+    while (files) {
+        g_free(files->data);
+        files = g_slist_delete_link(files, files);
+    }
+}
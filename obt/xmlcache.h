@@ -0,0 +1,38 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/xmlcache.h for the Openbox window manager
+   Copyright (c) 2003-2007   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __obt_xmlcache_h
+#define __obt_xmlcache_h
+
+#include <libxml/parser.h>
+#include <glib.h>
+
+/* A binary copy of an XML document's tree, which can be turned back into a
+   document without parsing any XML.  It remembers the files that the
+   document was read from (including XIncluded ones), and is only used while
+   they are unchanged. */
+
+/*! Returns the document cached for the file at @path, or NULL if there is no
+  cached copy or the files it was read from have changed. */
+xmlDocPtr obt_xml_cache_load(const gchar *cache_dir, const gchar *path);
+
+/*! Saves a copy of the @doc, which was just read from the file at @path. */
+void obt_xml_cache_save(const gchar *cache_dir, const gchar *path,
+                        xmlDocPtr doc);
+
+#endif
@@ -319,6 +319,11 @@ gboolean xqueue_pending_local(void)
     return qnum != 0;
 }
 
+gulong xqueue_length_local(void)
+{
+    return qnum;
+}
+
 typedef struct _ObtXQueueCB {
     ObtXQueueFunc func;
 } ObtXQueueCB;
@@ -26,6 +26,9 @@
 #include "focus.h"
 #include "openbox.h"
 #include "debug.h"
+#include "stacking.h"
+#include "framerender.h"
+#include "obt/trace.h"
 
 #include "actions/all.h"
 
@@ -38,6 +41,12 @@ static ObActionsAct* actions_build_act_from_string(const gchar *name);
 static ObActionsAct *interactive_act = NULL;
 static guint         interactive_initial_state = 0;
 
+/*! How many action chains are running inside each other */
+static guint         batch_depth = 0;
+/*! An action in the running chains wanted enter events caused by its
+  changes to be ignored */
+static gboolean      batch_ignore_enters = FALSE;
+
 struct _ObActionsDefinition {
     guint ref;
 
@@ -322,6 +331,34 @@ static void actions_setup_data(ObActionsData *data,
     data->client = client;
 }
 
+/*! Starts holding back restacking and redrawing frames, so when a chain of
+  actions (or a ForEach) changes many windows, or one window many times, it
+  is only done once at the end */
+static void actions_begin_batch(void)
+{
+    if (batch_depth++ == 0) {
+        stacking_freeze();
+        framerender_freeze();
+    }
+}
+
+static void actions_end_batch(void)
+{
+    gulong ignore_start = 0;
+
+    g_assert(batch_depth > 0);
+
+    if (--batch_depth) return;
+
+    if (batch_ignore_enters)
+        ignore_start = event_start_ignore_all_enters();
+    framerender_thaw();
+    stacking_thaw();
+    if (batch_ignore_enters)
+        event_end_ignore_all_enters(ignore_start);
+    batch_ignore_enters = FALSE;
+}
+
 void actions_run_acts(GSList *acts,
                       ObUserAction uact,
                       guint state,
@@ -334,6 +371,8 @@ void actions_run_acts(GSList *acts,
     GSList *it;
     gboolean update_user_time;
 
+    OBT_TRACE_BEGIN("actions_run_acts");
+
     /* Don't allow saving the initial state when running things from the
        menu */
     if (uact == OB_USER_ACTION_MENU_SELECTION)
@@ -342,6 +381,8 @@ void actions_run_acts(GSList *acts,
     if (x < 0 && y < 0)
         screen_pointer_pos(&x, &y);
 
+    actions_begin_batch();
+
     update_user_time = FALSE;
     for (it = acts; it; it = g_slist_next(it)) {
         ObActionsData data;
@@ -382,8 +423,13 @@ void actions_run_acts(GSList *acts,
             }
         }
     }
+
+    actions_end_batch();
+
     if (update_user_time)
         event_update_user_time();
+
+    OBT_TRACE_END("actions_run_acts");
 }
 
 gboolean actions_interactive_act_running(void)
@@ -487,7 +533,11 @@ void actions_client_move(ObActionsData *data, gboolean start)
                 }
             }
         }
-        else if (!data->button && !config_focus_under_mouse)
+        else if (!data->button && !config_focus_under_mouse) {
             event_end_ignore_all_enters(ignore_start);
+            /* the restacking hasn't been done yet, so ignore what it causes
+               too */
+            if (batch_depth) batch_ignore_enters = TRUE;
+        }
     }
 }
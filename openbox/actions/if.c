@@ -46,36 +46,53 @@ typedef struct {
     } m;
 } TypedMatch;
 
+/* The parts of a window's state which a query can test.  They are found for
+   a window all at once, and tested with a single mask. */
+typedef enum {
+    STATE_SHADED          = 1 << 0,
+    STATE_ICONIC          = 1 << 1,
+    STATE_MAXHORZ         = 1 << 2,
+    STATE_MAXVERT         = 1 << 3,
+    STATE_MAXFULL         = 1 << 4,
+    STATE_FOCUSED         = 1 << 5,
+    STATE_URGENT          = 1 << 6,
+    STATE_TITLEBAR        = 1 << 7,
+    STATE_OMNIPRESENT     = 1 << 8,
+    STATE_CURRENT_DESKTOP = 1 << 9
+} StateBit;
+
+typedef enum {
+    MATCH_FIELD_TITLE,
+    MATCH_FIELD_CLASS,
+    MATCH_FIELD_NAME,
+    MATCH_FIELD_ROLE,
+    MATCH_FIELD_TYPE,
+    NUM_MATCH_FIELDS
+} MatchField;
+
+typedef struct {
+    MatchField field;
+    TypedMatch tm;
+} Matcher;
+
+/* Don't remember the string matches for more windows than this, as the
+   entries for windows which changed or went away are never removed */
+#define MAX_CACHED_RESULTS 1024
+
 typedef struct {
     QueryTarget target;
-    gboolean shaded_on;
-    gboolean shaded_off;
-    gboolean maxvert_on;
-    gboolean maxvert_off;
-    gboolean maxhorz_on;
-    gboolean maxhorz_off;
-    gboolean maxfull_on;
-    gboolean maxfull_off;
-    gboolean iconic_on;
-    gboolean iconic_off;
-    gboolean focused;
-    gboolean unfocused;
-    gboolean urgent_on;
-    gboolean urgent_off;
-    gboolean decor_off;
-    gboolean decor_on;
-    gboolean omnipresent_on;
-    gboolean omnipresent_off;
-    gboolean desktop_current;
-    gboolean desktop_other;
+    /* the StateBits to test, and the values they need to have */
+    guint    state_mask;
+    guint    state_want;
     guint    desktop_number;
     guint    screendesktop_number;
     guint    client_monitor;
-    TypedMatch title;
-    TypedMatch class;
-    TypedMatch name;
-    TypedMatch role;
-    TypedMatch type;
+    /* the string matchers, the cheapest first */
+    Matcher  matchers[NUM_MATCH_FIELDS];
+    guint    n_matchers;
+    /* the result of the string matchers for windows, keyed by the window's
+       match_stamp */
+    GHashTable *results;
 } Query;
 
 typedef struct {
@@ -103,16 +120,16 @@ void action_if_startup(void)
 
 static inline void set_bool(xmlNodePtr node,
                             const char *name,
-                            gboolean *on,
-                            gboolean *off)
+                            Query *q,
+                            StateBit bit,
+                            gboolean invert)
 {
     xmlNodePtr n;
 
     if ((n = obt_xml_find_node(node, name))) {
-        if (obt_xml_node_bool(n))
-            *on = TRUE;
-        else
-            *off = TRUE;
+        q->state_mask |= bit;
+        if (obt_xml_node_bool(n) != invert)
+            q->state_want |= bit;
     }
 }
 
@@ -170,30 +187,73 @@ static gboolean check_typed_match(TypedMatch *tm, const gchar *s)
     g_assert_not_reached();
 }
 
+/* how expensive a match is to check, relative to the others */
+static gint typed_match_cost(const TypedMatch *tm)
+{
+    switch (tm->type) {
+    case MATCH_TYPE_EXACT:
+        return 0;
+    case MATCH_TYPE_PATTERN:
+        return 1;
+    case MATCH_TYPE_REGEX:
+        return 2;
+    case MATCH_TYPE_NONE:
+        break;
+    }
+    return 0;
+}
+
+static gint matcher_cmp(gconstpointer a, gconstpointer b)
+{
+    const Matcher *ma = a, *mb = b;
+    gint c;
+
+    c = typed_match_cost(&ma->tm) - typed_match_cost(&mb->tm);
+    /* keep the order from the config file otherwise */
+    return c ? c : (gint)ma->field - (gint)mb->field;
+}
+
+static void setup_matcher(Query *q, xmlNodePtr node, const gchar *name,
+                          MatchField field)
+{
+    xmlNodePtr n;
+
+    if ((n = obt_xml_find_node(node, name))) {
+        Matcher *m = &q->matchers[q->n_matchers];
+
+        m->field = field;
+        setup_typed_match(&m->tm, n);
+        if (m->tm.type != MATCH_TYPE_NONE)
+            ++q->n_matchers;
+    }
+}
+
 static void setup_query(Options* o, xmlNodePtr node, QueryTarget target) {
     Query *q = g_slice_new0(Query);
     g_array_append_val(o->queries, q);
 
     q->target = target;
 
-    set_bool(node, "shaded", &q->shaded_on, &q->shaded_off);
-    set_bool(node, "maximized", &q->maxfull_on, &q->maxfull_off);
-    set_bool(node, "maximizedhorizontal", &q->maxhorz_on, &q->maxhorz_off);
-    set_bool(node, "maximizedvertical", &q->maxvert_on, &q->maxvert_off);
-    set_bool(node, "iconified", &q->iconic_on, &q->iconic_off);
-    set_bool(node, "focused", &q->focused, &q->unfocused);
-    set_bool(node, "urgent", &q->urgent_on, &q->urgent_off);
-    set_bool(node, "undecorated", &q->decor_off, &q->decor_on);
-    set_bool(node, "omnipresent", &q->omnipresent_on, &q->omnipresent_off);
+    set_bool(node, "shaded", q, STATE_SHADED, FALSE);
+    set_bool(node, "maximized", q, STATE_MAXFULL, FALSE);
+    set_bool(node, "maximizedhorizontal", q, STATE_MAXHORZ, FALSE);
+    set_bool(node, "maximizedvertical", q, STATE_MAXVERT, FALSE);
+    set_bool(node, "iconified", q, STATE_ICONIC, FALSE);
+    set_bool(node, "focused", q, STATE_FOCUSED, FALSE);
+    set_bool(node, "urgent", q, STATE_URGENT, FALSE);
+    set_bool(node, "undecorated", q, STATE_TITLEBAR, TRUE);
+    set_bool(node, "omnipresent", q, STATE_OMNIPRESENT, FALSE);
 
     xmlNodePtr n;
     if ((n = obt_xml_find_node(node, "desktop"))) {
         gchar *s;
         if ((s = obt_xml_node_string(n))) {
-            if (!g_ascii_strcasecmp(s, "current"))
-                q->desktop_current = TRUE;
+            if (!g_ascii_strcasecmp(s, "current")) {
+                q->state_mask |= STATE_CURRENT_DESKTOP;
+                q->state_want |= STATE_CURRENT_DESKTOP;
+            }
             if (!g_ascii_strcasecmp(s, "other"))
-                q->desktop_other = TRUE;
+                q->state_mask |= STATE_CURRENT_DESKTOP;
             else
                 q->desktop_number = atoi(s);
             g_free(s);
@@ -202,24 +262,19 @@ static void setup_query(Options* o, xmlNodePtr node, QueryTarget target) {
     if ((n = obt_xml_find_node(node, "activedesktop"))) {
         q->screendesktop_number = obt_xml_node_int(n);
     }
-    if ((n = obt_xml_find_node(node, "title"))) {
-        setup_typed_match(&q->title, n);
-    }
-    if ((n = obt_xml_find_node(node, "class"))) {
-        setup_typed_match(&q->class, n);
-    }
-    if ((n = obt_xml_find_node(node, "name"))) {
-        setup_typed_match(&q->name, n);
-    }
-    if ((n = obt_xml_find_node(node, "role"))) {
-        setup_typed_match(&q->role, n);
-    }
-    if ((n = obt_xml_find_node(node, "type"))) {
-        setup_typed_match(&q->type, n);
-    }
+    setup_matcher(q, node, "title", MATCH_FIELD_TITLE);
+    setup_matcher(q, node, "class", MATCH_FIELD_CLASS);
+    setup_matcher(q, node, "name", MATCH_FIELD_NAME);
+    setup_matcher(q, node, "role", MATCH_FIELD_ROLE);
+    setup_matcher(q, node, "type", MATCH_FIELD_TYPE);
     if ((n = obt_xml_find_node(node, "monitor"))) {
         q->client_monitor = obt_xml_node_int(n);
     }
+
+    if (q->n_matchers) {
+        qsort(q->matchers, q->n_matchers, sizeof(Matcher), matcher_cmp);
+        q->results = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
 }
 
 static gpointer setup_func(xmlNodePtr node)
@@ -284,11 +339,11 @@ static void free_func(gpointer options)
     for (i = 0; i < o->queries->len; ++i) {
         Query *q = g_array_index(o->queries, Query*, i);
 
-        free_typed_match(&q->title);
-        free_typed_match(&q->class);
-        free_typed_match(&q->name);
-        free_typed_match(&q->role);
-        free_typed_match(&q->type);
+        guint j;
+
+        for (j = 0; j < q->n_matchers; ++j)
+            free_typed_match(&q->matchers[j].tm);
+        if (q->results) g_hash_table_destroy(q->results);
 
         g_slice_free(Query, q);
     }
@@ -306,6 +361,63 @@ static void free_func(gpointer options)
     g_slice_free(Options, o);
 }
 
+static guint client_state(ObClient *c)
+{
+    guint state = 0;
+
+    if (c->shaded) state |= STATE_SHADED;
+    if (c->iconic) state |= STATE_ICONIC;
+    if (c->max_horz) state |= STATE_MAXHORZ;
+    if (c->max_vert) state |= STATE_MAXVERT;
+    if (c->max_horz && c->max_vert) state |= STATE_MAXFULL;
+    if (c == focus_client) state |= STATE_FOCUSED;
+    if (c->urgent || c->demands_attention) state |= STATE_URGENT;
+    if (!c->undecorated && (c->decorations & OB_FRAME_DECOR_TITLEBAR))
+        state |= STATE_TITLEBAR;
+    if (c->desktop == DESKTOP_ALL)
+        state |= STATE_OMNIPRESENT | STATE_CURRENT_DESKTOP;
+    else if (c->desktop == screen_desktop)
+        state |= STATE_CURRENT_DESKTOP;
+    return state;
+}
+
+static const gchar *match_field_string(ObClient *c, MatchField field)
+{
+    switch (field) {
+    case MATCH_FIELD_TITLE: return c->original_title;
+    case MATCH_FIELD_CLASS: return c->class;
+    case MATCH_FIELD_NAME:  return c->name;
+    case MATCH_FIELD_ROLE:  return c->role;
+    case MATCH_FIELD_TYPE:  return client_type_to_string(c);
+    case NUM_MATCH_FIELDS:  break;
+    }
+    g_assert_not_reached();
+}
+
+/*! Checks the query's string matchers against the window.  The strings only
+  change along with the window's match_stamp, so the result is remembered
+  for that stamp. */
+static gboolean check_matchers(Query *q, ObClient *c)
+{
+    gpointer key = GUINT_TO_POINTER(c->match_stamp);
+    gpointer val;
+    gboolean r;
+    guint i;
+
+    if (g_hash_table_lookup_extended(q->results, key, NULL, &val))
+        return GPOINTER_TO_INT(val);
+
+    r = TRUE;
+    for (i = 0; r && i < q->n_matchers; ++i)
+        r = check_typed_match(&q->matchers[i].tm,
+                              match_field_string(c, q->matchers[i].field));
+
+    if (g_hash_table_size(q->results) >= MAX_CACHED_RESULTS)
+        g_hash_table_remove_all(q->results);
+    g_hash_table_insert(q->results, key, GINT_TO_POINTER(r));
+    return r;
+}
+
 /* Always return FALSE because its not interactive */
 static gboolean run_func_if(ObActionsData *data, gpointer options)
 {
@@ -333,65 +445,10 @@ static gboolean run_func_if(ObActionsData *data, gpointer options)
             break;
         }
 
-        if (q->shaded_on)
-            is_true &= query_target->shaded;
-        if (q->shaded_off)
-            is_true &= !query_target->shaded;
-
-        if (q->iconic_on)
-            is_true &= query_target->iconic;
-        if (q->iconic_off)
-            is_true &= !query_target->iconic;
-
-        if (q->maxhorz_on)
-            is_true &= query_target->max_horz;
-        if (q->maxhorz_off)
-            is_true &= !query_target->max_horz;
-
-        if (q->maxvert_on)
-            is_true &= query_target->max_vert;
-        if (q->maxvert_off)
-            is_true &= !query_target->max_vert;
-
-        gboolean is_max_full =
-            query_target->max_vert && query_target->max_horz;
-        if (q->maxfull_on)
-            is_true &= is_max_full;
-        if (q->maxfull_off)
-            is_true &= !is_max_full;
-
-        if (q->focused)
-            is_true &= query_target == focus_client;
-        if (q->unfocused)
-            is_true &= query_target != focus_client;
-
-        gboolean is_urgent =
-            query_target->urgent || query_target->demands_attention;
-        if (q->urgent_on)
-            is_true &= is_urgent;
-        if (q->urgent_off)
-            is_true &= !is_urgent;
-
-        gboolean has_visible_title_bar =
-            !query_target->undecorated &&
-            (query_target->decorations & OB_FRAME_DECOR_TITLEBAR);
-        if (q->decor_on)
-            is_true &= has_visible_title_bar;
-        if (q->decor_off)
-            is_true &= !has_visible_title_bar;
-
-        if (q->omnipresent_on)
-            is_true &= query_target->desktop == DESKTOP_ALL;
-        if (q->omnipresent_off)
-            is_true &= query_target->desktop != DESKTOP_ALL;
-
-        gboolean is_on_current_desktop =
-            query_target->desktop == screen_desktop ||
-            query_target->desktop == DESKTOP_ALL;
-        if (q->desktop_current)
-            is_true &= is_on_current_desktop;
-        if (q->desktop_other)
-            is_true &= !is_on_current_desktop;
+        if ((client_state(query_target) & q->state_mask) != q->state_want) {
+            is_true = FALSE;
+            break;
+        }
 
         if (q->desktop_number) {
             gboolean is_on_desktop =
@@ -403,15 +460,11 @@ static gboolean run_func_if(ObActionsData *data, gpointer options)
         if (q->screendesktop_number)
             is_true &= screen_desktop == q->screendesktop_number - 1;
 
-        is_true &= check_typed_match(&q->title, query_target->original_title);
-        is_true &= check_typed_match(&q->class, query_target->class);
-        is_true &= check_typed_match(&q->name, query_target->name);
-        is_true &= check_typed_match(&q->role, query_target->role);
-        is_true &= check_typed_match(&q->type,
-                                     client_type_to_string(query_target));
+        if (is_true && q->n_matchers)
+            is_true = check_matchers(q, query_target);
 
-        if (q->client_monitor)
-            is_true &= client_monitor(query_target) == q->client_monitor - 1;
+        if (is_true && q->client_monitor)
+            is_true = client_monitor(query_target) == q->client_monitor - 1;
 
     }
 
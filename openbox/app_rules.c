@@ -0,0 +1,331 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   app_rules.c for the Openbox window manager
+   Copyright (c) 2003-2007   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "app_rules.h"
+
+#include <string.h>
+
+typedef enum {
+    KEY_EXACT,
+    KEY_PREFIX,
+    KEY_SUFFIX,
+    KEY_NONE
+} KeyKind;
+
+typedef struct _Rule {
+    guint order;
+    GPatternSpec *spec[OB_APP_RULE_NUM_FIELDS];
+    gint type;
+    gpointer data;
+} Rule;
+
+/*! Rules keyed by one field's value, or by the start or end of it */
+typedef struct _Bucket {
+    /* maps a string to a GSList of Rules */
+    GHashTable *rules;
+    /* the distinct key lengths, for prefix and suffix buckets */
+    GArray *lengths;
+} Bucket;
+
+struct _ObAppRules {
+    Rule **all;
+    guint n;
+
+    Bucket exact[OB_APP_RULE_NUM_FIELDS];
+    Bucket prefix[OB_APP_RULE_NUM_FIELDS];
+    Bucket suffix[OB_APP_RULE_NUM_FIELDS];
+
+    /* the rules which can't be found through a key */
+    GSList *rest;
+
+    /* a bit for each field which any rule matches against */
+    guint fields;
+};
+
+/* the fields to key a rule by, most specific first */
+static const ObAppRuleField key_order[OB_APP_RULE_NUM_FIELDS] = {
+    OB_APP_RULE_CLASS,
+    OB_APP_RULE_NAME,
+    OB_APP_RULE_ROLE,
+    OB_APP_RULE_GROUP_CLASS,
+    OB_APP_RULE_GROUP_NAME,
+    OB_APP_RULE_TITLE
+};
+
+static void bucket_init(Bucket *b, gboolean lengths)
+{
+    b->rules = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                     (GDestroyNotify)g_slist_free);
+    b->lengths = lengths ? g_array_new(FALSE, FALSE, sizeof(guint)) : NULL;
+}
+
+static void bucket_clear(Bucket *b)
+{
+    g_hash_table_destroy(b->rules);
+    if (b->lengths) g_array_free(b->lengths, TRUE);
+}
+
+static void bucket_add(Bucket *b, const gchar *key, guint len, Rule *r)
+{
+    GSList *list;
+    gchar *k;
+
+    k = g_strndup(key, len);
+    if ((list = g_hash_table_lookup(b->rules, k))) {
+        /* the order doesn't matter, so add it after the head and leave the
+           table alone */
+        list->next = g_slist_prepend(list->next, r);
+        g_free(k);
+    }
+    else
+        g_hash_table_insert(b->rules, k, g_slist_prepend(NULL, r));
+
+    if (b->lengths) {
+        guint i;
+
+        for (i = 0; i < b->lengths->len; ++i)
+            if (g_array_index(b->lengths, guint, i) == len)
+                break;
+        if (i == b->lengths->len)
+            g_array_append_val(b->lengths, len);
+    }
+}
+
+/*! Adds the rules keyed by @key to the candidates */
+static void bucket_find(Bucket *b, const gchar *key, GPtrArray *found)
+{
+    GSList *it;
+
+    for (it = g_hash_table_lookup(b->rules, key); it; it = g_slist_next(it))
+        g_ptr_array_add(found, it->data);
+}
+
+/*! Returns how a pattern can be used as a key, and the plain part of it */
+static KeyKind pattern_key(const gchar *pattern, const gchar **key,
+                           guint *len)
+{
+    guint l = strlen(pattern);
+    const gchar *wild = strpbrk(pattern, "*?");
+
+    if (!wild) {
+        *key = pattern;
+        *len = l;
+        return KEY_EXACT;
+    }
+    if (wild == pattern + l - 1 && *wild == '*') {
+        *key = pattern;
+        *len = l - 1;
+        return KEY_PREFIX;
+    }
+    if (wild == pattern && *wild == '*' && !strpbrk(pattern + 1, "*?")) {
+        *key = pattern + 1;
+        *len = l - 1;
+        return KEY_SUFFIX;
+    }
+    return KEY_NONE;
+}
+
+ObAppRules* app_rules_new(void)
+{
+    ObAppRules *self;
+    gint i;
+
+    self = g_slice_new0(ObAppRules);
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS; ++i) {
+        bucket_init(&self->exact[i], FALSE);
+        bucket_init(&self->prefix[i], TRUE);
+        bucket_init(&self->suffix[i], TRUE);
+    }
+    return self;
+}
+
+void app_rules_free(ObAppRules *self)
+{
+    guint i;
+    gint f;
+
+    if (!self) return;
+
+    for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f) {
+        bucket_clear(&self->exact[f]);
+        bucket_clear(&self->prefix[f]);
+        bucket_clear(&self->suffix[f]);
+    }
+    g_slist_free(self->rest);
+
+    for (i = 0; i < self->n; ++i) {
+        Rule *r = self->all[i];
+        for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f)
+            if (r->spec[f]) g_pattern_spec_free(r->spec[f]);
+        g_slice_free(Rule, r);
+    }
+    g_free(self->all);
+    g_slice_free(ObAppRules, self);
+}
+
+void app_rules_add(ObAppRules *self,
+                   const gchar *const patterns[OB_APP_RULE_NUM_FIELDS],
+                   gint type, gpointer data)
+{
+    Rule *r;
+    gint i;
+    KeyKind best = KEY_NONE;
+    ObAppRuleField best_field = 0;
+    const gchar *best_key = NULL;
+    guint best_len = 0;
+
+    r = g_slice_new(Rule);
+    r->order = self->n;
+    r->type = type;
+    r->data = data;
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS; ++i) {
+        r->spec[i] = patterns[i] ? g_pattern_spec_new(patterns[i]) : NULL;
+        if (patterns[i]) self->fields |= 1 << i;
+    }
+
+    self->all = g_renew(Rule*, self->all, self->n + 1);
+    self->all[self->n++] = r;
+
+    /* key the rule by its most specific field.  a plain string is better
+       than a prefix or suffix, and an empty prefix or suffix matches
+       everything so it is no good at all */
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS && best != KEY_EXACT; ++i) {
+        ObAppRuleField f = key_order[i];
+        const gchar *key;
+        guint len;
+        KeyKind k;
+
+        if (!patterns[f]) continue;
+
+        k = pattern_key(patterns[f], &key, &len);
+        if (k == KEY_NONE || (k != KEY_EXACT && len == 0)) continue;
+        if (k < best) {
+            best = k;
+            best_field = f;
+            best_key = key;
+            best_len = len;
+        }
+    }
+
+    switch (best) {
+    case KEY_EXACT:
+        bucket_add(&self->exact[best_field], best_key, best_len, r);
+        break;
+    case KEY_PREFIX:
+        bucket_add(&self->prefix[best_field], best_key, best_len, r);
+        break;
+    case KEY_SUFFIX:
+        bucket_add(&self->suffix[best_field], best_key, best_len, r);
+        break;
+    case KEY_NONE:
+        self->rest = g_slist_append(self->rest, r);
+        break;
+    }
+}
+
+gboolean app_rules_uses_field(ObAppRules *self, ObAppRuleField field)
+{
+    return (self->fields & (1 << field)) != 0;
+}
+
+static gboolean rule_matches(Rule *r,
+                             const gchar *const values[OB_APP_RULE_NUM_FIELDS],
+                             gint type)
+{
+    gint i;
+
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS; ++i)
+        if (r->spec[i] && !g_pattern_match_string(r->spec[i], values[i]))
+            return FALSE;
+    return r->type < 0 || r->type == type;
+}
+
+static gint rule_cmp(gconstpointer a, gconstpointer b)
+{
+    const Rule *ra = *(Rule *const*)a, *rb = *(Rule *const*)b;
+    return ra->order < rb->order ? -1 : (ra->order > rb->order ? 1 : 0);
+}
+
+GSList* app_rules_match(ObAppRules *self,
+                        const gchar *const values[OB_APP_RULE_NUM_FIELDS],
+                        gint type)
+{
+    GPtrArray *found;
+    GSList *rest, *matched = NULL;
+    GString *buf = NULL;
+    guint i;
+    gint f;
+
+    found = g_ptr_array_new();
+
+    for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f) {
+        const gchar *v = values[f];
+        guint vlen = strlen(v);
+        GArray *lens;
+
+        bucket_find(&self->exact[f], v, found);
+
+        lens = self->prefix[f].lengths;
+        for (i = 0; i < lens->len; ++i) {
+            guint l = g_array_index(lens, guint, i);
+            if (l <= vlen) {
+                if (!buf) buf = g_string_sized_new(64);
+                g_string_truncate(buf, 0);
+                g_string_append_len(buf, v, l);
+                bucket_find(&self->prefix[f], buf->str, found);
+            }
+        }
+
+        lens = self->suffix[f].lengths;
+        for (i = 0; i < lens->len; ++i) {
+            guint l = g_array_index(lens, guint, i);
+            if (l <= vlen)
+                bucket_find(&self->suffix[f], v + vlen - l, found);
+        }
+    }
+
+    if (buf) g_string_free(buf, TRUE);
+
+    /* each rule is in one place in the index, so there are no duplicates.
+       later rules override earlier ones, so give them back in order, by
+       merging the few rules found through the index with the rest, which
+       are kept in order */
+    g_ptr_array_sort(found, rule_cmp);
+
+    i = 0;
+    rest = self->rest;
+    while (i < found->len || rest) {
+        Rule *r;
+
+        if (rest && (i == found->len ||
+                     ((Rule*)rest->data)->order <
+                     ((Rule*)g_ptr_array_index(found, i))->order))
+        {
+            r = rest->data;
+            rest = g_slist_next(rest);
+        }
+        else
+            r = g_ptr_array_index(found, i++);
+
+        if (rule_matches(r, values, type))
+            matched = g_slist_prepend(matched, r->data);
+    }
+    g_ptr_array_free(found, TRUE);
+
+    return g_slist_reverse(matched);
+}
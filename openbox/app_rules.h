@@ -0,0 +1,69 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   app_rules.h for the Openbox window manager
+   Copyright (c) 2003-2007   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __app_rules_h
+#define __app_rules_h
+
+#include <glib.h>
+
+/*! The properties of a window that a rule can match against */
+typedef enum {
+    OB_APP_RULE_NAME,
+    OB_APP_RULE_CLASS,
+    OB_APP_RULE_GROUP_NAME,
+    OB_APP_RULE_GROUP_CLASS,
+    OB_APP_RULE_ROLE,
+    OB_APP_RULE_TITLE,
+    OB_APP_RULE_NUM_FIELDS
+} ObAppRuleField;
+
+/*! An index of the per-app rules, which finds the rules matching a window
+  without trying every rule against it.  Rules whose patterns are plain
+  strings, or only have a * at the start or end, are found by hashing the
+  window's properties.  Only rules with other wildcards are tried against
+  every window. */
+typedef struct _ObAppRules ObAppRules;
+
+ObAppRules* app_rules_new(void);
+void app_rules_free(ObAppRules *self);
+
+/*! Adds a rule to the index.
+  @param patterns A glob pattern for each ObAppRuleField, or NULL to match
+                  any value
+  @param type The window type to match, or -1 to match any type
+  @param data Returned when the rule matches a window
+*/
+void app_rules_add(ObAppRules *self,
+                   const gchar *const patterns[OB_APP_RULE_NUM_FIELDS],
+                   gint type, gpointer data);
+
+/*! Returns TRUE if any rule looks at the given field, so a change to it
+  could change which rules match a window */
+gboolean app_rules_uses_field(ObAppRules *self, ObAppRuleField field);
+
+/*! Finds the rules which match a window.
+  @param values The window's value for each ObAppRuleField, none are NULL
+  @param type The window's type
+  @return The data of each matching rule, in the order they were added.
+          Free the list with g_slist_free().
+*/
+GSList* app_rules_match(ObAppRules *self,
+                        const gchar *const values[OB_APP_RULE_NUM_FIELDS],
+                        gint type);
+
+#endif
@@ -0,0 +1,214 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   app_rules_bench.c for the Openbox window manager
+   Copyright (c) 2003-2007   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Matches a set of synthetic windows against a set of per-app rules, once
+   by trying every rule against every window, and once with the index in
+   app_rules.c, and compares the results and the time each took.
+
+   usage: app_rules_bench [rules] [windows]
+*/
+
+#include "app_rules.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_TYPES 8
+
+typedef struct {
+    GPatternSpec *spec[OB_APP_RULE_NUM_FIELDS];
+    gint type;
+} LinearRule;
+
+typedef struct {
+    gchar *values[OB_APP_RULE_NUM_FIELDS];
+    gint type;
+} FakeWindow;
+
+/*! Makes the patterns for rule @i, mixing the kinds of patterns a real
+  rc.xml might have: mostly plain class names, with some prefixes, suffixes
+  and other wildcards */
+static void make_rule(gint i, gchar *patterns[OB_APP_RULE_NUM_FIELDS],
+                      gint *type)
+{
+    gint f;
+
+    for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f)
+        patterns[f] = NULL;
+    *type = -1;
+
+    switch (i % 25) {
+    default:
+        patterns[OB_APP_RULE_CLASS] = g_strdup_printf("App%d", i);
+        break;
+    case 1: case 2:
+        patterns[OB_APP_RULE_CLASS] = g_strdup_printf("App%d", i);
+        patterns[OB_APP_RULE_NAME] = g_strdup_printf("app%d", i);
+        *type = i % NUM_TYPES;
+        break;
+    case 3: case 4:
+        patterns[OB_APP_RULE_NAME] = g_strdup_printf("tool%d-*", i);
+        break;
+    case 5: case 6:
+        patterns[OB_APP_RULE_TITLE] = g_strdup_printf("* - Editor %d", i);
+        break;
+    case 7:
+        patterns[OB_APP_RULE_TITLE] = g_strdup_printf("*Term?%d*", i);
+        break;
+    }
+}
+
+static void make_window(GRand *r, gint nrules, FakeWindow *w)
+{
+    gint i = g_rand_int_range(r, 0, nrules * 2);
+
+    if (i % 25 == 3)
+        w->values[OB_APP_RULE_NAME] = g_strdup_printf("tool%d-%u", i,
+                                                      g_rand_int(r) % 100);
+    else
+        w->values[OB_APP_RULE_NAME] = g_strdup_printf("app%d", i);
+    w->values[OB_APP_RULE_CLASS] = g_strdup_printf("App%d", i);
+    w->values[OB_APP_RULE_GROUP_NAME] = g_strdup("");
+    w->values[OB_APP_RULE_GROUP_CLASS] = g_strdup("");
+    w->values[OB_APP_RULE_ROLE] = g_strdup("");
+    if (i % 25 == 5)
+        w->values[OB_APP_RULE_TITLE] = g_strdup_printf("file.c - Editor %d",
+                                                       i);
+    else if (i % 25 == 7)
+        w->values[OB_APP_RULE_TITLE] = g_strdup_printf("xTermA%d: ~", i);
+    else
+        w->values[OB_APP_RULE_TITLE] = g_strdup_printf("Window %d", i);
+    w->type = g_rand_int_range(r, 0, NUM_TYPES);
+}
+
+static GSList* linear_match(LinearRule *rules, gint nrules, FakeWindow *w)
+{
+    GSList *matched = NULL;
+    gint i, f;
+
+    for (i = 0; i < nrules; ++i) {
+        gboolean match = TRUE;
+
+        for (f = 0; match && f < OB_APP_RULE_NUM_FIELDS; ++f)
+            if (rules[i].spec[f] &&
+                !g_pattern_match_string(rules[i].spec[f], w->values[f]))
+                match = FALSE;
+        if (match && rules[i].type >= 0 && rules[i].type != w->type)
+            match = FALSE;
+        if (match)
+            matched = g_slist_prepend(matched, GINT_TO_POINTER(i));
+    }
+    return g_slist_reverse(matched);
+}
+
+static gboolean same_list(GSList *a, GSList *b)
+{
+    for (; a && b; a = a->next, b = b->next)
+        if (a->data != b->data) return FALSE;
+    return a == b;
+}
+
+gint main(gint argc, gchar **argv)
+{
+    gint nrules = 800, nwindows = 10000;
+    gint i, f, nmatched = 0;
+    LinearRule *linear;
+    FakeWindow *windows;
+    ObAppRules *rules;
+    GRand *r;
+    GTimer *t;
+    gdouble tlinear, tindex;
+    gboolean ok = TRUE;
+
+    if (argc > 1) nrules = MAX(1, atoi(argv[1]));
+    if (argc > 2) nwindows = MAX(1, atoi(argv[2]));
+
+    linear = g_new(LinearRule, nrules);
+    rules = app_rules_new();
+    for (i = 0; i < nrules; ++i) {
+        gchar *patterns[OB_APP_RULE_NUM_FIELDS];
+
+        make_rule(i, patterns, &linear[i].type);
+        for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f)
+            linear[i].spec[f] =
+                patterns[f] ? g_pattern_spec_new(patterns[f]) : NULL;
+        app_rules_add(rules, (const gchar *const*)patterns, linear[i].type,
+                      GINT_TO_POINTER(i));
+        for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f)
+            g_free(patterns[f]);
+    }
+
+    r = g_rand_new_with_seed(42);
+    windows = g_new(FakeWindow, nwindows);
+    for (i = 0; i < nwindows; ++i)
+        make_window(r, nrules, &windows[i]);
+    g_rand_free(r);
+
+    t = g_timer_new();
+
+    g_timer_start(t);
+    for (i = 0; i < nwindows; ++i)
+        g_slist_free(linear_match(linear, nrules, &windows[i]));
+    tlinear = g_timer_elapsed(t, NULL);
+
+    g_timer_start(t);
+    for (i = 0; i < nwindows; ++i)
+        g_slist_free(app_rules_match(rules,
+                                     (const gchar *const*)windows[i].values,
+                                     windows[i].type));
+    tindex = g_timer_elapsed(t, NULL);
+
+    /* make sure the index finds exactly the same rules */
+    for (i = 0; i < nwindows; ++i) {
+        GSList *a, *b;
+
+        a = linear_match(linear, nrules, &windows[i]);
+        b = app_rules_match(rules, (const gchar *const*)windows[i].values,
+                            windows[i].type);
+        if (!same_list(a, b)) {
+            printf("window %d (class %s, title %s) matched differently\n",
+                   i, windows[i].values[OB_APP_RULE_CLASS],
+                   windows[i].values[OB_APP_RULE_TITLE]);
+            ok = FALSE;
+        }
+        if (a) ++nmatched;
+        g_slist_free(a);
+        g_slist_free(b);
+    }
+
+    printf("%d rules, %d windows (%d matched at least one rule)\n",
+           nrules, nwindows, nmatched);
+    printf("  every rule: %8.2f ms  (%.2f us/window)\n",
+           tlinear * 1000, tlinear * 1e6 / nwindows);
+    printf("  indexed:    %8.2f ms  (%.2f us/window)\n",
+           tindex * 1000, tindex * 1e6 / nwindows);
+
+    g_timer_destroy(t);
+    app_rules_free(rules);
+    for (i = 0; i < nrules; ++i)
+        for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f)
+            if (linear[i].spec[f]) g_pattern_spec_free(linear[i].spec[f]);
+    g_free(linear);
+    for (i = 0; i < nwindows; ++i)
+        for (f = 0; f < OB_APP_RULE_NUM_FIELDS; ++f)
+            g_free(windows[i].values[f]);
+    g_free(windows);
+
+    return ok ? 0 : 1;
+}
@@ -32,6 +32,7 @@
 #include "prompt.h"
 #include "focus.h"
 #include "focus_cycle.h"
+#include "focus_cycle_popup.h"
 #include "stacking.h"
 #include "openbox.h"
 #include "group.h"
@@ -39,11 +40,14 @@
 #include "menuframe.h"
 #include "keyboard.h"
 #include "mouse.h"
+#include "restart_state.h"
 #include "obrender/render.h"
 #include "gettext.h"
+#include "metrics.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
 #include "obt/prop.h"
+#include "obt/trace.h"
 
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
@@ -54,7 +58,9 @@
 #endif
 
 #include <glib.h>
+#include <string.h>
 #include <X11/Xutil.h>
+#include <X11/Xatom.h>
 
 /*! The event mask to grab on client windows */
 #define CLIENT_EVENTMASK (PropertyChangeMask | StructureNotifyMask | \
@@ -72,8 +78,41 @@ GList          *client_list             = NULL;
 
 static GSList  *client_destroy_notifies = NULL;
 static RrImage *client_default_icon     = NULL;
+static guint    client_next_match_stamp = 1;
+/*! When more than 0, the client list is not set on the root window */
+static guint    client_list_frozen      = 0;
+static gboolean client_list_changed     = FALSE;
+
+/*! The properties read off the window by client_get_all, which are all asked
+  for together before it starts */
+static const ObtPropAtom client_prefetch_props[] = {
+    OBT_PROP_MOTIF_WM_HINTS,
+    OBT_PROP_NET_STARTUP_ID,
+    OBT_PROP_NET_WM_DESKTOP,
+    OBT_PROP_NET_WM_ICON_GEOMETRY,
+    OBT_PROP_NET_WM_ICON_NAME,
+    OBT_PROP_NET_WM_NAME,
+    OBT_PROP_NET_WM_PID,
+    OBT_PROP_NET_WM_STATE,
+    OBT_PROP_NET_WM_STRUT,
+    OBT_PROP_NET_WM_STRUT_PARTIAL,
+    OBT_PROP_NET_WM_SYNC_REQUEST_COUNTER,
+    OBT_PROP_NET_WM_USER_TIME,
+    OBT_PROP_NET_WM_WINDOW_OPACITY,
+    OBT_PROP_NET_WM_WINDOW_TYPE,
+    OBT_PROP_SM_CLIENT_ID,
+    OBT_PROP_WM_CLASS,
+    OBT_PROP_WM_CLIENT_LEADER,
+    OBT_PROP_WM_CLIENT_MACHINE,
+    OBT_PROP_WM_COMMAND,
+    OBT_PROP_WM_ICON_NAME,
+    OBT_PROP_WM_NAME,
+    OBT_PROP_WM_PROTOCOLS,
+    OBT_PROP_WM_WINDOW_ROLE
+};
 
 static void client_get_all(ObClient *self, gboolean real);
+static void client_prefetch(Window window);
 static void client_get_startup_id(ObClient *self);
 static void client_get_session_ids(ObClient *self);
 static void client_save_app_rule_values(ObClient *self);
@@ -94,6 +133,10 @@ static void client_apply_startup_state(ObClient *self,
 static void client_restore_session_state(ObClient *self);
 static gboolean client_restore_session_stacking(ObClient *self);
 static ObAppSettings *client_get_settings_state(ObClient *self);
+static void client_match_app_rules(ObClient *self);
+static void client_update_app_rules(ObClient *self);
+static void client_forget_app_rules(ObClient *self);
+static void client_get_class(ObClient *self, Window leader);
 static void client_update_transient_tree(ObClient *self,
                                          ObGroup *oldgroup, ObGroup *newgroup,
                                          gboolean oldgtran, gboolean newgtran,
@@ -120,7 +163,16 @@ void client_startup(gboolean reconfig)
         ob_rr_icons, ob_rr_theme->def_win_icon,
         ob_rr_theme->def_win_icon_w, ob_rr_theme->def_win_icon_h);
 
-    if (reconfig) return;
+    if (reconfig) {
+        GList *it;
+
+        /* the per-app settings were all reloaded, so find which of the new
+           ones match each window.  they are not applied to windows which are
+           already managed, as a reconfigure never did that */
+        for (it = client_list; it; it = g_list_next(it))
+            client_match_app_rules(it->data);
+        return;
+    }
 
     client_set_list();
 }
@@ -169,7 +221,14 @@ void client_set_list(void)
 {
     Window *windows, *win_it;
     GList *it;
-    guint size = g_list_length(client_list);
+    guint size;
+
+    if (client_list_frozen) {
+        client_list_changed = TRUE;
+        return;
+    }
+
+    size = g_list_length(client_list);
 
     /* create an array of the window ids */
     if (size > 0) {
@@ -189,6 +248,23 @@ void client_set_list(void)
     stacking_set_list();
 }
 
+void client_list_freeze(void)
+{
+    ++client_list_frozen;
+}
+
+void client_list_thaw(void)
+{
+    g_assert(client_list_frozen > 0);
+
+    if (--client_list_frozen) return;
+
+    if (client_list_changed) {
+        client_list_changed = FALSE;
+        client_set_list();
+    }
+}
+
 void client_manage(Window window, ObPrompt *prompt)
 {
     ObClient *self;
@@ -203,6 +279,8 @@ void client_manage(Window window, ObPrompt *prompt)
     gboolean obplaced;
     gulong ignore_start = FALSE;
 
+    OBT_TRACE_BEGIN("client_manage");
+
     ob_debug("Managing window: 0x%lx", window);
 
     /* choose the events we want to receive on the CLIENT window
@@ -223,11 +301,14 @@ void client_manage(Window window, ObPrompt *prompt)
 
     /* non-zero defaults */
     self->wmstate = WithdrawnState; /* make sure it gets updated first time */
+    self->net_wm_state_num = -1; /* and this too */
     self->gravity = NorthWestGravity;
     self->desktop = screen_num_desktops; /* always an invalid value */
 
     /* get all the stuff off the window */
+    client_prefetch(window);
     client_get_all(self, TRUE);
+    obt_prop_prefetch_end();
 
     ob_debug("Window type: %d", self->type);
     ob_debug("Window group: 0x%x", self->group?self->group->leader:0);
@@ -521,6 +602,8 @@ void client_manage(Window window, ObPrompt *prompt)
 
     ob_debug("Managed window 0x%lx plate 0x%x (%s)",
              window, self->frame->window, self->class);
+
+    OBT_TRACE_END("client_manage");
 }
 
 ObClient *client_fake_manage(Window window)
@@ -534,6 +617,7 @@ ObClient *client_fake_manage(Window window)
 
     self = g_slice_new0(ObClient);
     self->window = window;
+    self->net_wm_state_num = -1;
 
     client_get_all(self, FALSE);
     /* per-app settings override stuff, and return the settings for other
@@ -599,6 +683,7 @@ void client_unmanage(ObClient *self)
 
     /* update the focus lists */
     focus_order_remove(self);
+    focus_cycle_popup_forget(self);
     if (client_focused(self)) {
         /* don't leave an invalid focus_client */
         focus_client = NULL;
@@ -711,6 +796,7 @@ void client_unmanage(ObClient *self)
     g_free(self->group_class);
     g_free(self->client_machine);
     g_free(self->sm_client_id);
+    client_forget_app_rules(self);
     g_slice_free(ObClient, self);
 }
 
@@ -719,6 +805,7 @@ void client_fake_unmanage(ObClient *self)
     /* this is all that got allocated to get the decorations */
 
     frame_free(self->frame);
+    client_forget_app_rules(self);
     g_slice_free(ObClient, self);
 }
 
@@ -886,60 +973,160 @@ static gboolean client_can_steal_focus(ObClient *self,
     return steal;
 }
 
-/*! Returns a new structure containing the per-app settings for this client.
-  The returned structure needs to be freed with g_free. */
-static ObAppSettings *client_get_settings_state(ObClient *self)
+static void client_app_rule_values(ObClient *self,
+                                   const gchar *values[OB_APP_RULE_NUM_FIELDS])
+{
+    values[OB_APP_RULE_NAME] = self->name;
+    values[OB_APP_RULE_CLASS] = self->class;
+    values[OB_APP_RULE_GROUP_NAME] = self->group_name;
+    values[OB_APP_RULE_GROUP_CLASS] = self->group_class;
+    values[OB_APP_RULE_ROLE] = self->role;
+    values[OB_APP_RULE_TITLE] = self->title;
+}
+
+/*! Finds the per-app settings which match the window, and remembers them
+  along with the values they were matched against */
+static void client_match_app_rules(ObClient *self)
+{
+    const gchar *values[OB_APP_RULE_NUM_FIELDS];
+    gint i;
+
+    client_app_rule_values(self, values);
+
+    g_slist_free(self->app_settings);
+    self->app_settings = app_rules_match(config_per_app_rules,
+                                         values, self->type);
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS; ++i) {
+        g_free(self->app_rule_values[i]);
+        self->app_rule_values[i] = g_strdup(values[i]);
+    }
+}
+
+static void client_forget_app_rules(ObClient *self)
+{
+    gint i;
+
+    g_slist_free(self->app_settings);
+    self->app_settings = NULL;
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS; ++i) {
+        g_free(self->app_rule_values[i]);
+        self->app_rule_values[i] = NULL;
+    }
+}
+
+/*! Returns a new structure with the settings from the list merged together.
+  The returned structure needs to be freed with g_slice_free. */
+static ObAppSettings *client_merge_app_settings(ObClient *self, GSList *list)
 {
     ObAppSettings *settings;
     GSList *it;
 
     settings = config_create_app_settings();
 
-    for (it = config_per_app_settings; it; it = g_slist_next(it)) {
+    for (it = list; it; it = g_slist_next(it)) {
         ObAppSettings *app = it->data;
-        gboolean match = TRUE;
-
-        g_assert(app->name != NULL || app->class != NULL ||
-                 app->role != NULL || app->title != NULL ||
-                 app->group_name != NULL || app->group_class != NULL ||
-                 (signed)app->type >= 0);
-
-        if (app->name &&
-            !g_pattern_match(app->name, strlen(self->name), self->name, NULL))
-            match = FALSE;
-        else if (app->group_name &&
-            !g_pattern_match(app->group_name,
-                             strlen(self->group_name), self->group_name, NULL))
-            match = FALSE;
-        else if (app->class &&
-                 !g_pattern_match(app->class,
-                                  strlen(self->class), self->class, NULL))
-            match = FALSE;
-        else if (app->group_class &&
-                 !g_pattern_match(app->group_class,
-                                  strlen(self->group_class), self->group_class,
-                                  NULL))
-            match = FALSE;
-        else if (app->role &&
-                 !g_pattern_match(app->role,
-                                  strlen(self->role), self->role, NULL))
-            match = FALSE;
-        else if (app->title &&
-                 !g_pattern_match(app->title,
-                                  strlen(self->title), self->title, NULL))
-            match = FALSE;
-        else if ((signed)app->type >= 0 && app->type != self->type) {
-            match = FALSE;
-        }
 
-        if (match) {
-            ob_debug("Window matching: %s", app->name);
+        ob_debug("Window matching: %s", self->name);
 
-            /* copy the settings to our struct, overriding the existing
-               settings if they are not defaults */
-            config_app_settings_copy_non_defaults(app, settings);
-        }
+        /* copy the settings to our struct, overriding the existing
+           settings if they are not defaults */
+        config_app_settings_copy_non_defaults(app, settings);
+    }
+    return settings;
+}
+
+/*! Applies the per-app settings in new which are different from those in
+  old.  Only the window's state is changed, its position, size, monitor and
+  focus are only set from the per-app settings when it is mapped. */
+static void client_apply_app_settings_changes(ObClient *self,
+                                              const ObAppSettings *old,
+                                              const ObAppSettings *new)
+{
+#define CHANGED(field, def) (new->field != (def) && new->field != old->field)
+
+    if (CHANGED(decor, -1))
+        client_set_undecorated(self, !new->decor);
+    if (CHANGED(shade, -1))
+        client_shade(self, !!new->shade);
+    if (CHANGED(layer, -2))
+        client_set_layer(self, new->layer);
+
+    if (CHANGED(desktop, 0)) {
+        if (new->desktop == DESKTOP_ALL)
+            client_set_desktop(self, DESKTOP_ALL, FALSE, TRUE);
+        else if (new->desktop > 0 && new->desktop <= screen_num_desktops)
+            client_set_desktop(self, new->desktop - 1, FALSE, TRUE);
+    }
+
+    if (CHANGED(skip_pager, -1) || CHANGED(skip_taskbar, -1)) {
+        if (new->skip_pager != -1)
+            self->skip_pager = !!new->skip_pager;
+        if (new->skip_taskbar != -1)
+            self->skip_taskbar = !!new->skip_taskbar;
+        client_change_state(self);
+    }
+
+    if (CHANGED(fullscreen, -1))
+        client_fullscreen(self, !!new->fullscreen);
+    if (CHANGED(max_horz, -1))
+        client_maximize(self, !!new->max_horz, 1);
+    if (CHANGED(max_vert, -1))
+        client_maximize(self, !!new->max_vert, 2);
+    if (CHANGED(iconic, -1))
+        client_iconify(self, !!new->iconic, FALSE, FALSE);
+
+#undef CHANGED
+}
+
+/*! Matches the per-app rules against the window again if one of the
+  properties which they look at has changed since they were last matched, and
+  applies the settings which change because of it */
+static void client_update_app_rules(ObClient *self)
+{
+    const gchar *values[OB_APP_RULE_NUM_FIELDS];
+    GSList *old, *it, *jt;
+    gboolean changed;
+    gint i;
+
+    /* not matched yet, that happens once all the properties are read */
+    if (!self->app_rule_values[0]) return;
+
+    client_app_rule_values(self, values);
+
+    changed = FALSE;
+    for (i = 0; i < OB_APP_RULE_NUM_FIELDS && !changed; ++i)
+        changed = strcmp(values[i], self->app_rule_values[i]) &&
+            app_rules_uses_field(config_per_app_rules, i);
+    if (!changed) return;
+
+    old = self->app_settings;
+    self->app_settings = NULL;
+    client_match_app_rules(self);
+
+    for (it = old, jt = self->app_settings; it && jt;
+         it = g_slist_next(it), jt = g_slist_next(jt))
+        if (it->data != jt->data) break;
+
+    if (it || jt) {
+        ObAppSettings *before, *after;
+
+        before = client_merge_app_settings(self, old);
+        after = client_merge_app_settings(self, self->app_settings);
+        client_apply_app_settings_changes(self, before, after);
+        g_slice_free(ObAppSettings, before);
+        g_slice_free(ObAppSettings, after);
     }
+    g_slist_free(old);
+}
+
+/*! Returns a new structure containing the per-app settings for this client.
+  The returned structure needs to be freed with g_free. */
+static ObAppSettings *client_get_settings_state(ObClient *self)
+{
+    ObAppSettings *settings;
+
+    client_match_app_rules(self);
+    settings = client_merge_app_settings(self, self->app_settings);
 
     if (settings->shade != -1)
         self->shaded = !!settings->shade;
@@ -1185,6 +1372,19 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
     return ox != *x || oy != *y;
 }
 
+/*! Asks for the properties client_get_all reads, so they are waited for once
+  instead of one at a time.  _NET_WM_ICON is left out as it can be large, and
+  is read under a server grab. */
+static void client_prefetch(Window window)
+{
+    Atom props[G_N_ELEMENTS(client_prefetch_props)];
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(client_prefetch_props); ++i)
+        props[i] = obt_prop_atom(client_prefetch_props[i]);
+    obt_prop_prefetch(window, props, G_N_ELEMENTS(props));
+}
+
 static void client_get_all(ObClient *self, gboolean real)
 {
     /* this is needed for the frame to set itself up */
@@ -1261,6 +1461,7 @@ static void client_get_area(ObClient *self)
     XWindowAttributes wattrib;
     Status ret;
 
+    metrics_round_trip();
     ret = XGetWindowAttributes(obt_display, self->window, &wattrib);
     g_assert(ret != BadWindow);
 
@@ -1612,6 +1813,8 @@ void client_get_type_and_transientness(ObClient *self)
     {
         self->transient = TRUE;
     }
+
+    self->match_stamp = client_next_match_stamp++;
 }
 
 void client_update_protocols(ObClient *self)
@@ -1670,6 +1873,7 @@ static void client_get_colormap(ObClient *self)
 {
     XWindowAttributes wa;
 
+    metrics_round_trip();
     if (XGetWindowAttributes(obt_display, self->window, &wa))
         client_update_colormap(self, wa.colormap);
 }
@@ -1994,6 +2198,7 @@ void client_update_wmhints(ObClient *self)
     /* assume a window takes input if it doesn't specify */
     self->can_focus = TRUE;
 
+    metrics_round_trip();
     if ((hints = XGetWMHints(obt_display, self->window)) != NULL) {
         gboolean ur;
 
@@ -2148,6 +2353,30 @@ void client_update_title(ObClient *self)
 
     OBT_PROP_SETS(self->window, NET_WM_VISIBLE_ICON_NAME, visible);
     self->icon_title = visible;
+
+    self->match_stamp = client_next_match_stamp++;
+    client_update_app_rules(self);
+}
+
+void client_update_class(ObClient *self)
+{
+    guint32 leader;
+
+    if (!OBT_PROP_GET32(self->window, WM_CLIENT_LEADER, WINDOW, &leader))
+        leader = None;
+
+    g_free(self->name);
+    g_free(self->class);
+    g_free(self->group_name);
+    g_free(self->group_class);
+    g_free(self->role);
+    self->name = self->class = NULL;
+    self->group_name = self->group_class = NULL;
+    self->role = NULL;
+
+    client_get_class(self, leader);
+    self->match_stamp = client_next_match_stamp++;
+    client_update_app_rules(self);
 }
 
 void client_update_strut(ObClient *self)
@@ -2210,6 +2439,8 @@ void client_update_icons(ObClient *self)
     guint32 *data;
     guint w, h, i, j;
     RrImage *img;
+    ObtPropCookie icon_req, hints_req;
+    gboolean asked = FALSE;
 
     img = NULL;
 
@@ -2218,7 +2449,20 @@ void client_update_icons(ObClient *self)
        icon */
     grab_server(TRUE);
 
-    if (OBT_PROP_GETA32(self->window, NET_WM_ICON, CARDINAL, &data, &num)) {
+    /* if openbox just restarted, it may have handed over this window's
+       icons, which saves reading and decoding them again */
+    img = restart_state_icon(self->window);
+
+    if (!img) {
+        /* ask for the legacy icon along with the _NET_WM_ICON, so it costs no
+           more waiting if the window has only that one */
+        metrics_round_trip();
+        icon_req = OBT_PROP_REQUEST(self->window, NET_WM_ICON, CARDINAL);
+        hints_req = obt_prop_request(self->window, XA_WM_HINTS, XA_WM_HINTS);
+        asked = TRUE;
+    }
+
+    if (asked && obt_prop_reply_array32(&icon_req, &data, &num)) {
         /* figure out how many valid icons are in here */
         i = 0;
         while (i + 2 < num) { /* +2 is to make sure there is a w and h */
@@ -2253,17 +2497,20 @@ void client_update_icons(ObClient *self)
 
     /* if we didn't find an image from the NET_WM_ICON stuff, then try the
        legacy X hints */
-    if (!img) {
-        XWMHints *hints;
-
-        if ((hints = XGetWMHints(obt_display, self->window))) {
-            if (hints->flags & IconPixmapHint) {
+    if (!img && asked) {
+        guint32 *hints;
+        guint nhints;
+
+        /* the raw XWMHints, where [0] is the flags, [3] the icon pixmap and
+           [7] the icon mask */
+        if (obt_prop_reply_array32(&hints_req, &hints, &nhints)) {
+            if (nhints >= 8 && (hints[0] & IconPixmapHint)) {
                 gboolean xicon;
                 obt_display_ignore_errors(TRUE);
                 xicon = RrPixmapToRGBA(ob_rr_inst,
-                                       hints->icon_pixmap,
-                                       (hints->flags & IconMaskHint ?
-                                        hints->icon_mask : None),
+                                       hints[3],
+                                       (hints[0] & IconMaskHint ?
+                                        hints[7] : None),
                                        (gint*)&w, (gint*)&h, &data);
                 obt_display_ignore_errors(FALSE);
 
@@ -2278,9 +2525,11 @@ void client_update_icons(ObClient *self)
                     g_free(data);
                 }
             }
-            XFree(hints);
+            g_free(hints);
         }
     }
+    else if (asked)
+        obt_prop_discard(&hints_req);
 
     /* set the client's icons to be whatever we found */
     RrImageUnref(self->icon_set);
@@ -2331,22 +2580,14 @@ void client_update_icon_geometry(ObClient *self)
     }
 }
 
-static void client_get_session_ids(ObClient *self)
+/*! Gets the window's name, class and role, and the name and class of its
+  group leader */
+static void client_get_class(ObClient *self, Window leader)
 {
-    guint32 leader;
     gboolean got;
     gchar *s;
     gchar **ss;
 
-    if (!OBT_PROP_GET32(self->window, WM_CLIENT_LEADER, WINDOW, &leader))
-        leader = None;
-
-    /* get the SM_CLIENT_ID */
-    if (leader && leader != self->window)
-        OBT_PROP_GETS_XPCS(leader, SM_CLIENT_ID, &self->sm_client_id);
-    else
-        OBT_PROP_GETS_XPCS(self->window, SM_CLIENT_ID, &self->sm_client_id);
-
     /* get the WM_CLASS (name and class). make them "" if they are not
        provided */
     got = OBT_PROP_GETSS_TYPE(self->window, WM_CLASS, STRING_NO_CC, &ss);
@@ -2389,6 +2630,25 @@ static void client_get_session_ids(ObClient *self)
         self->role = s;
     else
         self->role = g_strdup("");
+}
+
+static void client_get_session_ids(ObClient *self)
+{
+    guint32 leader;
+    gboolean got;
+    gchar *s;
+    gchar **ss;
+
+    if (!OBT_PROP_GET32(self->window, WM_CLIENT_LEADER, WINDOW, &leader))
+        leader = None;
+
+    /* get the SM_CLIENT_ID */
+    if (leader && leader != self->window)
+        OBT_PROP_GETS_XPCS(leader, SM_CLIENT_ID, &self->sm_client_id);
+    else
+        OBT_PROP_GETS_XPCS(self->window, SM_CLIENT_ID, &self->sm_client_id);
+
+    client_get_class(self, leader);
 
     /* get the WM_COMMAND */
     got = FALSE;
@@ -2508,7 +2768,7 @@ static void client_change_wm_state(ObClient *self)
 
 static void client_change_state(ObClient *self)
 {
-    gulong netstate[12];
+    gulong netstate[OB_CLIENT_NUM_NET_WM_STATES];
     guint num;
 
     num = 0;
@@ -2536,7 +2796,16 @@ static void client_change_state(ObClient *self)
         netstate[num++] = OBT_PROP_ATOM(NET_WM_STATE_DEMANDS_ATTENTION);
     if (self->undecorated)
         netstate[num++] = OBT_PROP_ATOM(OB_WM_STATE_UNDECORATED);
-    OBT_PROP_SETA32(self->window, NET_WM_STATE, ATOM, netstate, num);
+    g_assert(num <= OB_CLIENT_NUM_NET_WM_STATES);
+
+    /* don't make the pagers read the same state again */
+    if ((gint)num != self->net_wm_state_num ||
+        memcmp(netstate, self->net_wm_state, num * sizeof(gulong)))
+    {
+        OBT_PROP_SETA32(self->window, NET_WM_STATE, ATOM, netstate, num);
+        memcpy(self->net_wm_state, netstate, num * sizeof(gulong));
+        self->net_wm_state_num = num;
+    }
 
     if (self->frame)
         frame_adjust_state(self->frame);
@@ -3736,6 +4005,7 @@ static void client_set_desktop_recursive(ObClient *self,
 
         old = self->desktop;
         self->desktop = target;
+        focus_order_desktop_changed(self, old);
         OBT_PROP_SET32(self->window, NET_WM_DESKTOP, CARDINAL, target);
         /* the frame can display the current desktop state */
         frame_adjust_state(self->frame);
@@ -3812,6 +4082,7 @@ gboolean client_validate(ObClient *self)
 {
     struct ObClientFindDestroyUnmap find;
 
+    metrics_round_trip();
     XSync(obt_display, FALSE); /* get all events on the server */
 
     find.window = self->window;
@@ -21,6 +21,7 @@
 #define __client_h
 
 #include "misc.h"
+#include "app_rules.h"
 #include "mwm.h"
 #include "geom.h"
 #include "stacking.h"
@@ -41,6 +42,9 @@ struct _ObPrompt;
 
 typedef struct _ObClient      ObClient;
 
+/*! The most _NET_WM_STATE atoms that openbox sets on a window at once */
+#define OB_CLIENT_NUM_NET_WM_STATES 12
+
 /*! Possible window types */
 typedef enum
 {
@@ -104,6 +108,15 @@ struct _ObClient
       desktops) */
     guint desktop;
 
+    /*! The window's link in focus_order, owned by the window, or NULL if it
+      is not in the focus order */
+    GList *focus_order_link;
+    /*! The window's link in the focus order for its desktop */
+    GList *focus_desktop_link;
+    /*! The window's place in focus_order, higher values are closer to the
+      top */
+    gint64 focus_rank;
+
     /*! The startup id for the startup-notification protocol. This will be
       NULL if a startup id is not set. */
     gchar *startup_id;
@@ -137,6 +150,17 @@ struct _ObClient
     /*! The type of window (what its function is) */
     ObClientType type;
 
+    /*! The per-app settings whose rules match the window, in the order they
+      apply */
+    GSList *app_settings;
+    /*! The window's properties when app_settings was found, indexed by
+      ObAppRuleField.  These are NULL until then. */
+    gchar *app_rule_values[OB_APP_RULE_NUM_FIELDS];
+    /*! Changes to a new value, never used by another window, whenever the
+      title, name, class, role or type of the window changes.  Things which
+      match against those can remember their result for a stamp. */
+    guint match_stamp;
+
     /*! Position and size of the window
       This will not always be the actual position of the window on screen, it
       is, rather, the position requested by the client, to which the window's
@@ -213,6 +237,11 @@ struct _ObClient
     /*! The state of the window, one of WithdrawnState, IconicState, or
       NormalState */
     glong wmstate;
+    /*! The _NET_WM_STATE atoms last set on the window, so that the property
+      is only written when it changes */
+    gulong net_wm_state[OB_CLIENT_NUM_NET_WM_STATES];
+    /*! The number of atoms in net_wm_state, or -1 if it was never set */
+    gint net_wm_state_num;
 
     /*! True if the client supports the delete_window protocol */
     gboolean delete_window;
@@ -353,6 +382,14 @@ void client_fake_unmanage(ObClient *self);
 /*! Sets the client list on the root window from the client_list */
 void client_set_list(void);
 
+/*! Stops client_set_list from setting the client list on the root window
+  until client_list_thaw is called the same number of times */
+void client_list_freeze(void);
+
+/*! Sets the client list on the root window, if it changed since
+  client_list_freeze was called */
+void client_list_thaw(void);
+
 /*! Determines if the client should be shown or hidden currently.
   @return TRUE if it should be visible; otherwise, FALSE.
 */
@@ -647,6 +684,9 @@ void client_update_normal_hints(ObClient *self);
 void client_update_wmhints(ObClient *self);
 /*! Updates the window's title and icon title */
 void client_update_title(ObClient *self);
+/*! Updates the window's name, class and role, and the group's name and
+  class */
+void client_update_class(ObClient *self);
 /*! Updates the strut for the client */
 void client_update_strut(ObClient *self);
 /*! Updates the window's icons */
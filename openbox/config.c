@@ -69,6 +69,7 @@ gboolean         config_resize_redraw;
 gint             config_resize_popup_show;
 ObResizePopupPos config_resize_popup_pos;
 GravityPoint     config_resize_popup_fixed;
+guint            config_resize_rate;
 
 ObStackingLayer config_dock_layer;
 gboolean        config_dock_floating;
@@ -105,6 +106,14 @@ gint     config_resist_win;
 gint     config_resist_edge;
 
 GSList *config_per_app_settings;
+ObAppRules *config_per_app_rules;
+
+ObConfigSection config_changed;
+
+/* the checksums of each group of sections from the last time the config file
+   was loaded, indexed by the group's bit in ObConfigSection */
+#define NUM_SECTIONS 5
+static gchar *section_sums[NUM_SECTIONS];
 
 ObAppSettings* config_create_app_settings(void)
 {
@@ -366,6 +375,7 @@ static void parse_per_app_settings(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
             type_set, group_name_set, group_class_set;
         gchar *name = NULL, *class = NULL, *role = NULL, *title = NULL,
             *type_str = NULL, *group_name = NULL, *group_class = NULL;
+        const gchar *patterns[OB_APP_RULE_NUM_FIELDS];
         ObClientType type;
 
         class_set = obt_xml_attr_string(app, "class", &class);
@@ -404,21 +414,19 @@ static void parse_per_app_settings(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
 
         settings = config_create_app_settings();
 
-        if (name_set)
-            settings->name = g_pattern_spec_new(name);
-        if (class_set)
-            settings->class = g_pattern_spec_new(class);
-        if (group_name_set)
-            settings->group_name = g_pattern_spec_new(group_name);
-        if (group_class_set)
-            settings->group_class = g_pattern_spec_new(group_class);
-        if (role_set)
-            settings->role = g_pattern_spec_new(role);
-        if (title_set)
-            settings->title = g_pattern_spec_new(title);
         if (type_set)
             settings->type = type;
 
+        /* the strings are left NULL if the attributes aren't there */
+        patterns[OB_APP_RULE_NAME] = name;
+        patterns[OB_APP_RULE_CLASS] = class;
+        patterns[OB_APP_RULE_GROUP_NAME] = group_name;
+        patterns[OB_APP_RULE_GROUP_CLASS] = group_class;
+        patterns[OB_APP_RULE_ROLE] = role;
+        patterns[OB_APP_RULE_TITLE] = title;
+        app_rules_add(config_per_app_rules, patterns,
+                      type_set ? (gint)type : -1, settings);
+
         g_free(name);
         g_free(class);
         g_free(group_name);
@@ -490,8 +498,6 @@ static void parse_keyboard(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
     xmlNodePtr n;
     gchar *key;
 
-    keyboard_unbind_all();
-
     if ((n = obt_xml_find_node(node->children, "chainQuitKey"))) {
         key = obt_xml_node_string(n);
         translate_key(key, &config_keyboard_reset_state,
@@ -499,11 +505,16 @@ static void parse_keyboard(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
         g_free(key);
     }
 
-    if ((n = obt_xml_find_node(node->children, "keybind")))
-        while (n) {
-            parse_key(n, NULL);
-            n = obt_xml_find_node(n->next, "keybind");
-        }
+    /* keep the bindings we already have if they haven't changed */
+    if (config_changed & OB_CONFIG_SECTION_KEYBOARD) {
+        keyboard_unbind_all();
+
+        if ((n = obt_xml_find_node(node->children, "keybind")))
+            while (n) {
+                parse_key(n, NULL);
+                n = obt_xml_find_node(n->next, "keybind");
+            }
+    }
 
     if ((n = obt_xml_find_node(node->children, "rebindOnMappingNotify")))
         config_keyboard_rebind_on_mapping_notify = obt_xml_node_bool(n);
@@ -526,8 +537,6 @@ static void parse_mouse(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
     gchar *cxstr;
     ObMouseAction mact;
 
-    mouse_unbind_all();
-
     node = node->children;
 
     if ((n = obt_xml_find_node(node, "dragThreshold")))
@@ -544,6 +553,12 @@ static void parse_mouse(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
     if ((n = obt_xml_find_node(node, "screenEdgeWarpMouse")))
         config_mouse_screenedgewarp = obt_xml_node_bool(n);
 
+    /* keep the bindings we already have if they haven't changed */
+    if (!(config_changed & OB_CONFIG_SECTION_MOUSE))
+        return;
+
+    mouse_unbind_all();
+
     for (n = obt_xml_find_node(node, "context");
          n;
          n = obt_xml_find_node(n->next, "context"))
@@ -856,6 +871,8 @@ static void parse_resize(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
             }
         }
     }
+    if ((n = obt_xml_find_node(node, "updateRate")))
+        config_resize_rate = MAX(obt_xml_node_int(n), 0);
 }
 
 static void parse_dock(xmlNodePtr node, G_GNUC_UNUSED gpointer d)
@@ -1067,6 +1084,48 @@ static void bind_default_mouse(void)
                    it->mact, actions_parse_string(it->actname));
 }
 
+static ObConfigSection section_group(const xmlChar *name)
+{
+    if (!xmlStrcmp(name, (const xmlChar*)"keyboard"))
+        return OB_CONFIG_SECTION_KEYBOARD;
+    if (!xmlStrcmp(name, (const xmlChar*)"mouse"))
+        return OB_CONFIG_SECTION_MOUSE;
+    if (!xmlStrcmp(name, (const xmlChar*)"theme"))
+        return OB_CONFIG_SECTION_THEME;
+    if (!xmlStrcmp(name, (const xmlChar*)"menu"))
+        return OB_CONFIG_SECTION_MENU;
+    return OB_CONFIG_SECTION_OTHER;
+}
+
+void config_compare(xmlNodePtr root)
+{
+    GChecksum *sums[NUM_SECTIONS];
+    xmlNodePtr n;
+    gint g;
+
+    for (g = 0; g < NUM_SECTIONS; ++g)
+        sums[g] = g_checksum_new(G_CHECKSUM_SHA1);
+
+    for (n = root ? root->children : NULL; n; n = n->next)
+        if (n->type == XML_ELEMENT_NODE) {
+            ObConfigSection s = section_group(n->name);
+            for (g = 0; !(s & (1 << g)); ++g);
+            obt_xml_checksum_node(sums[g], n);
+        }
+
+    config_changed = 0;
+    for (g = 0; g < NUM_SECTIONS; ++g) {
+        const gchar *sum = g_checksum_get_string(sums[g]);
+
+        if (!section_sums[g] || strcmp(sum, section_sums[g])) {
+            config_changed |= 1 << g;
+            g_free(section_sums[g]);
+            section_sums[g] = g_strdup(sum);
+        }
+        g_checksum_free(sums[g]);
+    }
+}
+
 void config_startup(ObtXmlInst *i)
 {
     config_focus_new = TRUE;
@@ -1120,6 +1179,7 @@ void config_startup(ObtXmlInst *i)
     config_resize_popup_pos = OB_RESIZE_POS_CENTER;
     GRAVITY_COORD_SET(config_resize_popup_fixed.x, 0, FALSE, FALSE);
     GRAVITY_COORD_SET(config_resize_popup_fixed.y, 0, FALSE, FALSE);
+    config_resize_rate = 0;
 
     obt_xml_register(i, "resize", parse_resize, NULL);
 
@@ -1142,7 +1202,10 @@ void config_startup(ObtXmlInst *i)
                   &config_keyboard_reset_keycode);
     config_keyboard_rebind_on_mapping_notify = TRUE;
 
-    bind_default_keyboard();
+    if (config_changed & OB_CONFIG_SECTION_KEYBOARD) {
+        keyboard_unbind_all();
+        bind_default_keyboard();
+    }
 
     obt_xml_register(i, "keyboard", parse_keyboard, NULL);
 
@@ -1151,7 +1214,10 @@ void config_startup(ObtXmlInst *i)
     config_mouse_screenedgetime = 400;
     config_mouse_screenedgewarp = FALSE;
 
-    bind_default_mouse();
+    if (config_changed & OB_CONFIG_SECTION_MOUSE) {
+        mouse_unbind_all();
+        bind_default_mouse();
+    }
 
     obt_xml_register(i, "mouse", parse_mouse, NULL);
 
@@ -1171,13 +1237,15 @@ void config_startup(ObtXmlInst *i)
     obt_xml_register(i, "menu", parse_menu, NULL);
 
     config_per_app_settings = NULL;
+    config_per_app_rules = app_rules_new();
 
     obt_xml_register(i, "applications", parse_per_app_settings, NULL);
 }
 
-void config_shutdown(void)
+void config_shutdown(gboolean reconfig)
 {
     GSList *it;
+    gint g;
 
     g_free(config_theme);
 
@@ -1198,15 +1266,15 @@ void config_shutdown(void)
         g_free(it->data);
     g_slist_free(config_menu_files);
 
-    for (it = config_per_app_settings; it; it = g_slist_next(it)) {
-        ObAppSettings *itd = (ObAppSettings *)it->data;
-        if (itd->name) g_pattern_spec_free(itd->name);
-        if (itd->role) g_pattern_spec_free(itd->role);
-        if (itd->title) g_pattern_spec_free(itd->title);
-        if (itd->class) g_pattern_spec_free(itd->class);
-        if (itd->group_name) g_pattern_spec_free(itd->group_name);
-        if (itd->group_class) g_pattern_spec_free(itd->group_class);
+    for (it = config_per_app_settings; it; it = g_slist_next(it))
         g_slice_free(ObAppSettings, it->data);
-    }
     g_slist_free(config_per_app_settings);
+    app_rules_free(config_per_app_rules);
+
+    if (reconfig) return;
+
+    for (g = 0; g < NUM_SECTIONS; ++g) {
+        g_free(section_sums[g]);
+        section_sums[g] = NULL;
+    }
 }
@@ -26,6 +26,7 @@
 #include "client.h"
 #include "geom.h"
 #include "moveresize.h"
+#include "app_rules.h"
 #include "obrender/render.h"
 #include "obt/xml.h"
 
@@ -33,14 +34,19 @@
 
 typedef struct _ObAppSettings ObAppSettings;
 
+/*! Groups of sections in the config file, by what needs to be done when
+  they change */
+typedef enum {
+    OB_CONFIG_SECTION_KEYBOARD = 1 << 0, /*!< key bindings */
+    OB_CONFIG_SECTION_MOUSE    = 1 << 1, /*!< mouse bindings */
+    OB_CONFIG_SECTION_THEME    = 1 << 2, /*!< the theme and fonts */
+    OB_CONFIG_SECTION_MENU     = 1 << 3, /*!< the menu files and options */
+    OB_CONFIG_SECTION_OTHER    = 1 << 4, /*!< everything else */
+    OB_CONFIG_SECTION_ALL      = (1 << 5) - 1
+} ObConfigSection;
+
 struct _ObAppSettings
 {
-    GPatternSpec *class;
-    GPatternSpec *name;
-    GPatternSpec *role;
-    GPatternSpec *group_class;
-    GPatternSpec *group_name;
-    GPatternSpec *title;
     ObClientType  type;
 
     GravityPoint position;
@@ -113,6 +119,9 @@ extern gint config_resize_popup_show;
 extern ObResizePopupPos config_resize_popup_pos;
 /*! where to place the popup if it's in a fixed position */
 extern GravityPoint config_resize_popup_fixed;
+/*! the most times per second that a window is moved or resized to follow the
+  pointer, or 0 to follow every motion event */
+extern guint config_resize_rate;
 
 /*! The stacking layer the dock will reside in */
 extern ObStackingLayer config_dock_layer;
@@ -215,9 +224,29 @@ extern gboolean config_menu_show_icons;
 extern GSList *config_menu_files;
 /*! Per app settings */
 extern GSList *config_per_app_settings;
+/*! The rules for choosing which per app settings apply to a window, with an
+  ObAppSettings as each rule's data */
+extern ObAppRules *config_per_app_rules;
+
+/*! The sections of the config file which changed the last time it was
+  loaded.  Everything has changed the first time. */
+extern ObConfigSection config_changed;
+
+/*! Compares the config file's sections against the last time it was loaded,
+  and sets config_changed.  Call this after the file is loaded, and before
+  config_startup().
+  @param root The root node of the config file, or NULL if there is none
+*/
+void config_compare(xmlNodePtr root);
 
+/*! Sets the default options and registers the config file's sections with
+  the parser.  The key and mouse bindings are only replaced if their
+  sections changed, otherwise the ones already bound are kept. */
 void config_startup(ObtXmlInst *i);
-void config_shutdown(void);
+/*! Frees the options.  The checksums of the config file's sections are
+  kept through a reconfigure, to compare the file against when it is loaded
+  again. */
+void config_shutdown(gboolean reconfig);
 
 /*! Create an ObAppSettings structure with the default values */
 ObAppSettings* config_create_app_settings(void);
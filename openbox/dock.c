@@ -23,6 +23,7 @@
 #include "config.h"
 #include "grab.h"
 #include "openbox.h"
+#include "metrics.h"
 #include "obrender/theme.h"
 #include "obt/prop.h"
 
@@ -157,6 +158,7 @@ void dock_manage(Window icon_win, Window name_win)
     if (app->name == NULL) app->name = g_strdup("");
     if (app->class == NULL) app->class = g_strdup("");
 
+    metrics_round_trip();
     if (XGetWindowAttributes(obt_display, app->icon_win, &attrib)) {
         app->w = attrib.width;
         app->h = attrib.height;
@@ -187,6 +189,7 @@ void dock_manage(Window icon_win, Window name_win)
         XMapWindow(obt_display, app->name_win);
     }
 
+    metrics_round_trip();
     XSync(obt_display, False);
 
     XSelectInput(obt_display, app->icon_win, DOCKAPP_EVENT_MASK);
@@ -211,6 +214,7 @@ void dock_unmanage(ObDockApp *app, gboolean reparent)
     XSelectInput(obt_display, app->icon_win, NoEventMask);
     /* remove the window from our save set */
     XChangeSaveSet(obt_display, app->icon_win, SetModeDelete);
+    metrics_round_trip();
     XSync(obt_display, False);
 
     if (reparent) {
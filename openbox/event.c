@@ -39,10 +39,12 @@
 #include "group.h"
 #include "stacking.h"
 #include "ping.h"
+#include "metrics.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
 #include "obt/prop.h"
 #include "obt/keyboard.h"
+#include "obt/trace.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
@@ -448,6 +450,45 @@ static void print_focusevent(XEvent *e)
 
 }
 
+/*! Remember the pointer position carried by events from the user, so that
+  anything asking where the pointer is while the event is handled does not
+  have to go to the server for it */
+static void event_track_pointer(XEvent *e)
+{
+    switch (e->type) {
+    case ButtonPress:
+    case ButtonRelease:
+        if (e->xbutton.same_screen && e->xbutton.root == obt_root(ob_screen)) {
+            screen_set_pointer_pos(e->xbutton.x_root, e->xbutton.y_root);
+            return;
+        }
+        break;
+    case KeyPress:
+    case KeyRelease:
+        if (e->xkey.same_screen && e->xkey.root == obt_root(ob_screen)) {
+            screen_set_pointer_pos(e->xkey.x_root, e->xkey.y_root);
+            return;
+        }
+        break;
+    case MotionNotify:
+        if (e->xmotion.same_screen && e->xmotion.root == obt_root(ob_screen)) {
+            screen_set_pointer_pos(e->xmotion.x_root, e->xmotion.y_root);
+            return;
+        }
+        break;
+    case EnterNotify:
+    case LeaveNotify:
+        if (e->xcrossing.same_screen &&
+            e->xcrossing.root == obt_root(ob_screen))
+        {
+            screen_set_pointer_pos(e->xcrossing.x_root, e->xcrossing.y_root);
+            return;
+        }
+        break;
+    }
+    screen_forget_pointer_pos();
+}
+
 static void event_process(const XEvent *ec)
 {
     XEvent ee, *e;
@@ -460,6 +501,9 @@ static void event_process(const XEvent *ec)
     ObPrompt *prompt = NULL;
     gboolean used;
 
+    OBT_TRACE_BEGIN("event_process");
+    metrics_event_start();
+
     /* make a copy we can mangle */
     ee = *ec;
     e = &ee;
@@ -494,6 +538,8 @@ static void event_process(const XEvent *ec)
     event_set_curtime(e);
     event_curserial = e->xany.serial;
     event_hack_mods(e);
+    /* after compressing motion, so the position is the latest one */
+    event_track_pointer(e);
 
     /* deal with it in the kernel */
 
@@ -743,6 +789,11 @@ static void event_process(const XEvent *ec)
        the time, so clear it here until the next event is handled */
     event_curtime = event_sourcetime = CurrentTime;
     event_curserial = 0;
+    /* and the pointer may move before the next event arrives */
+    screen_forget_pointer_pos();
+
+    metrics_event_end(e->type);
+    OBT_TRACE_END("event_process");
 }
 
 static void event_handle_root(XEvent *e)
@@ -789,6 +840,8 @@ static void event_handle_root(XEvent *e)
                 ob_restart();
             else if (e->xclient.data.l[0] == 3)
                 ob_exit(0);
+        } else if (msgtype == OBT_PROP_ATOM(OB_METRICS)) {
+            metrics_request(e->xclient.data.l[0]);
         } else if (msgtype == OBT_PROP_ATOM(WM_PROTOCOLS)) {
             if ((Atom)e->xclient.data.l[0] == OBT_PROP_ATOM(NET_WM_PING))
                 ping_got_pong(e->xclient.data.l[1]);
@@ -1675,6 +1728,9 @@ static void event_handle_client(ObClient *client, XEvent *e)
                    msgtype == OBT_PROP_ATOM(NET_WM_ICON_NAME) ||
                    msgtype == OBT_PROP_ATOM(WM_ICON_NAME)) {
             client_update_title(client);
+        } else if (msgtype == OBT_PROP_ATOM(WM_CLASS) ||
+                   msgtype == OBT_PROP_ATOM(WM_WINDOW_ROLE)) {
+            client_update_class(client);
         } else if (msgtype == OBT_PROP_ATOM(WM_PROTOCOLS)) {
             client_update_protocols(client);
         }
@@ -2237,6 +2293,7 @@ void event_cancel_all_key_grabs(void)
     else
         ungrab_passive_key();
 
+    metrics_round_trip();
     XSync(obt_display, FALSE);
 }
 
@@ -36,13 +36,35 @@
 
 #define FOCUS_INDICATOR_WIDTH 6
 
+/* the space left between the ranks of windows, so that they can be put
+   between others without renumbering them */
+#define RANK_GAP (1 << 16)
+
+#define LINK_RANK(it) (((ObClient*)(it)->data)->focus_rank)
+
 ObClient *focus_client = NULL;
 GList *focus_order = NULL;
 
+/*! The last link in focus_order */
+static GList *focus_order_tail = NULL;
+/*! The link in focus_order for the first iconic window */
+static GList *first_iconic = NULL;
+/*! A GQueue for each desktop (including DESKTOP_ALL), of the windows on it
+  in the same order as focus_order */
+static GHashTable *desktop_orders = NULL;
+
+static void desktop_order_free(gpointer q)
+{
+    g_queue_free(q);
+}
+
 void focus_startup(gboolean reconfig)
 {
     if (reconfig) return;
 
+    desktop_orders = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                           NULL, desktop_order_free);
+
     /* start with nothing focused */
     focus_nothing();
 }
@@ -53,6 +75,140 @@ void focus_shutdown(gboolean reconfig)
 
     /* reset focus to root */
     XSetInputFocus(obt_display, PointerRoot, RevertToNone, CurrentTime);
+
+    g_hash_table_destroy(desktop_orders);
+    desktop_orders = NULL;
+}
+
+static GQueue *desktop_order(guint desktop, gboolean create)
+{
+    GQueue *q;
+
+    q = g_hash_table_lookup(desktop_orders, GUINT_TO_POINTER(desktop));
+    if (!q && create) {
+        q = g_queue_new();
+        g_hash_table_insert(desktop_orders, GUINT_TO_POINTER(desktop), q);
+    }
+    return q;
+}
+
+static void desktop_order_add(ObClient *c)
+{
+    GQueue *q = desktop_order(c->desktop, TRUE);
+    GList *link = c->focus_desktop_link;
+    GList *it;
+
+    /* find the first window below this one */
+    for (it = q->head; it && LINK_RANK(it) > c->focus_rank;
+         it = g_list_next(it));
+
+    if (!it)
+        g_queue_push_tail_link(q, link);
+    else if (it == q->head)
+        g_queue_push_head_link(q, link);
+    else {
+        link->prev = it->prev;
+        link->next = it;
+        it->prev->next = link;
+        it->prev = link;
+        ++q->length;
+    }
+}
+
+static void desktop_order_remove(ObClient *c, guint desktop)
+{
+    GQueue *q = desktop_order(desktop, FALSE);
+
+    g_assert(q != NULL);
+    g_queue_unlink(q, c->focus_desktop_link);
+}
+
+/*! Gives a window a rank between the ranks of the windows around it */
+static void set_rank(GList *link)
+{
+    ObClient *c = link->data;
+
+    if (!link->prev && !link->next)
+        c->focus_rank = 0;
+    else if (!link->prev)
+        c->focus_rank = LINK_RANK(link->next) + RANK_GAP;
+    else if (!link->next)
+        c->focus_rank = LINK_RANK(link->prev) - RANK_GAP;
+    else if (LINK_RANK(link->prev) - LINK_RANK(link->next) > 1)
+        c->focus_rank = LINK_RANK(link->next) +
+            (LINK_RANK(link->prev) - LINK_RANK(link->next)) / 2;
+    else {
+        GList *it;
+        gint64 r;
+
+        /* there is no space left here, so spread them all out again.  this
+           keeps the order of the windows, so the desktop orders are still
+           right */
+        for (r = 0, it = focus_order_tail; it;
+             r += RANK_GAP, it = g_list_previous(it))
+            LINK_RANK(it) = r;
+    }
+}
+
+/*! Takes a window out of the focus order */
+static void order_unlink(ObClient *c)
+{
+    GList *link = c->focus_order_link;
+
+    if (!link) return;
+
+    if (link == first_iconic) {
+        for (first_iconic = link->next;
+             first_iconic && !((ObClient*)first_iconic->data)->iconic;
+             first_iconic = g_list_next(first_iconic));
+    }
+    if (link == focus_order_tail)
+        focus_order_tail = link->prev;
+    focus_order = g_list_remove_link(focus_order, link);
+    g_list_free_1(link);
+
+    desktop_order_remove(c, c->desktop);
+    g_list_free_1(c->focus_desktop_link);
+    c->focus_order_link = c->focus_desktop_link = NULL;
+}
+
+/*! Puts a window into the focus order above the sibling link, or at the
+  bottom if sibling is NULL */
+static void order_insert_before(ObClient *c, GList *sibling)
+{
+    GList *link;
+
+    g_assert(!c->focus_order_link);
+
+    link = c->focus_order_link = g_list_alloc();
+    link->data = c;
+    c->focus_desktop_link = g_list_alloc();
+    c->focus_desktop_link->data = c;
+
+    if (!sibling) {
+        link->prev = focus_order_tail;
+        link->next = NULL;
+        if (focus_order_tail)
+            focus_order_tail->next = link;
+        else
+            focus_order = link;
+        focus_order_tail = link;
+    } else {
+        link->prev = sibling->prev;
+        link->next = sibling;
+        if (sibling->prev)
+            sibling->prev->next = link;
+        else
+            focus_order = link;
+        sibling->prev = link;
+    }
+    set_rank(link);
+
+    if (c->iconic &&
+        (!first_iconic || c->focus_rank > LINK_RANK(first_iconic)))
+        first_iconic = link;
+
+    desktop_order_add(c);
 }
 
 static void push_to_top(ObClient *client)
@@ -65,8 +221,8 @@ static void push_to_top(ObClient *client)
     if (client->modal && (p = client_direct_parent(client)))
         push_to_top(p);
 
-    focus_order = g_list_remove(focus_order, client);
-    focus_order = g_list_prepend(focus_order, client);
+    order_unlink(client);
+    order_insert_before(client, focus_order);
 }
 
 void focus_set_client(ObClient *client)
@@ -106,12 +262,31 @@ void focus_set_client(ObClient *client)
     event_reset_user_time();
 }
 
+/*! Returns the next window in the focus order from two desktops' orders,
+  and moves past it */
+static ObClient* desktop_order_next(GList **a, GList **b)
+{
+    GList **n;
+    ObClient *c;
+
+    if (!*a && !*b) return NULL;
+
+    if (!*b || (*a && LINK_RANK(*a) > LINK_RANK(*b)))
+        n = a;
+    else
+        n = b;
+    c = (*n)->data;
+    *n = g_list_next(*n);
+    return c;
+}
+
 static ObClient* focus_fallback_target(gboolean allow_refocus,
                                        gboolean allow_pointer,
                                        gboolean allow_omnipresent,
                                        ObClient *old)
 {
-    GList *it;
+    GQueue *q;
+    GList *here, *all;
     ObClient *c;
 
     ob_debug_type(OB_DEBUG_FOCUS, "trying pointer stuff");
@@ -125,9 +300,15 @@ static ObClient* focus_fallback_target(gboolean allow_refocus,
             return c;
         }
 
+    /* only windows on the current desktop, or on all desktops, are valid
+       targets, so look at just those, in the focus order */
+    q = desktop_order(screen_desktop, FALSE);
+    here = q ? q->head : NULL;
+    q = desktop_order(DESKTOP_ALL, FALSE);
+    all = q && allow_omnipresent ? q->head : NULL;
+
     ob_debug_type(OB_DEBUG_FOCUS, "trying the focus order");
-    for (it = focus_order; it; it = g_list_next(it)) {
-        c = it->data;
+    while ((c = desktop_order_next(&here, &all))) {
         /* fallback focus to a window if:
            1. it is on the current desktop. this ignores omnipresent
            windows, which are problematic in their own rite, unless they are
@@ -148,9 +329,13 @@ static ObClient* focus_fallback_target(gboolean allow_refocus,
         }
     }
 
+    q = desktop_order(screen_desktop, FALSE);
+    here = q ? q->head : NULL;
+    q = desktop_order(DESKTOP_ALL, FALSE);
+    all = q ? q->head : NULL;
+
     ob_debug_type(OB_DEBUG_FOCUS, "trying a desktop window");
-    for (it = focus_order; it; it = g_list_next(it)) {
-        c = it->data;
+    while ((c = desktop_order_next(&here, &all))) {
         /* fallback focus to a window if:
            1. it is on the current desktop. this ignores omnipresent
            windows, which are problematic in their own rite.
@@ -206,13 +391,13 @@ void focus_order_add_new(ObClient *c)
     if (c->iconic)
         focus_order_to_top(c);
     else {
-        g_assert(!g_list_find(focus_order, c));
+        g_assert(!c->focus_order_link);
         /* if there are only iconic windows, put this above them in the order,
            but if there are not, then put it under the currently focused one */
         if (focus_order && ((ObClient*)focus_order->data)->iconic)
-            focus_order = g_list_insert(focus_order, c, 0);
+            order_insert_before(c, focus_order);
         else
-            focus_order = g_list_insert(focus_order, c, 1);
+            order_insert_before(c, focus_order ? focus_order->next : NULL);
     }
 
     focus_cycle_addremove(c, TRUE);
@@ -220,60 +405,67 @@ void focus_order_add_new(ObClient *c)
 
 void focus_order_remove(ObClient *c)
 {
-    focus_order = g_list_remove(focus_order, c);
+    order_unlink(c);
 
     focus_cycle_addremove(c, TRUE);
 }
 
 void focus_order_like_new(struct _ObClient *c)
 {
-    focus_order = g_list_remove(focus_order, c);
+    order_unlink(c);
     focus_order_add_new(c);
 }
 
 void focus_order_to_top(ObClient *c)
 {
-    focus_order = g_list_remove(focus_order, c);
-    if (!c->iconic) {
-        focus_order = g_list_prepend(focus_order, c);
-    } else {
-        GList *it;
-
+    order_unlink(c);
+    if (!c->iconic)
+        order_insert_before(c, focus_order);
+    else
         /* insert before first iconic window */
-        for (it = focus_order;
-             it && !((ObClient*)it->data)->iconic; it = g_list_next(it));
-        focus_order = g_list_insert_before(focus_order, it, c);
-    }
+        order_insert_before(c, first_iconic);
 
     focus_cycle_reorder();
 }
 
 void focus_order_to_bottom(ObClient *c)
 {
-    focus_order = g_list_remove(focus_order, c);
-    if (c->iconic) {
-        focus_order = g_list_append(focus_order, c);
-    } else {
-        GList *it;
-
+    order_unlink(c);
+    if (c->iconic)
+        order_insert_before(c, NULL);
+    else
         /* insert before first iconic window */
-        for (it = focus_order;
-             it && !((ObClient*)it->data)->iconic; it = g_list_next(it));
-        focus_order = g_list_insert_before(focus_order, it, c);
-    }
+        order_insert_before(c, first_iconic);
 
     focus_cycle_reorder();
 }
 
+void focus_order_desktop_changed(ObClient *c, guint old)
+{
+    if (!c->focus_order_link) return;
+
+    desktop_order_remove(c, old);
+    desktop_order_add(c);
+}
+
+GList *focus_order_desktop_list(guint desktop)
+{
+    GQueue *q = desktop_order(desktop, FALSE);
+
+    return q ? q->head : NULL;
+}
+
 ObClient *focus_order_find_first(guint desktop)
 {
-    GList *it;
-    for (it = focus_order; it; it = g_list_next(it)) {
-        ObClient *c = it->data;
-        if (c->desktop == desktop || c->desktop == DESKTOP_ALL)
-            return c;
-    }
-    return NULL;
+    GQueue *q;
+    GList *here, *all;
+
+    q = desktop_order(desktop, FALSE);
+    here = q ? q->head : NULL;
+    q = desktop_order(DESKTOP_ALL, FALSE);
+    all = q && desktop != DESKTOP_ALL ? q->head : NULL;
+
+    return desktop_order_next(&here, &all);
 }
 
 /*! Returns if a focus target has valid group siblings that can be cycled
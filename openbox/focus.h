@@ -66,8 +66,17 @@ void focus_order_like_new(struct _ObClient *c);
   very bottom always though). */
 void focus_order_to_bottom(struct _ObClient *c);
 
+/*! Moves a client into the focus order for its new desktop.  Call this when
+  its desktop changes. */
+void focus_order_desktop_changed(struct _ObClient *c, guint old);
+
 struct _ObClient *focus_order_find_first(guint desktop);
 
+/*! Returns the clients whose desktop is the given one, in focus order.  Use
+  DESKTOP_ALL for the clients on every desktop.  The list is owned by the
+  focus code and must not be modified. */
+GList *focus_order_desktop_list(guint desktop);
+
 gboolean focus_valid_target(struct _ObClient *ft,
                             guint    desktop,
                             gboolean helper_windows,
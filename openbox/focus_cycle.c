@@ -85,6 +85,15 @@ void focus_cycle_reorder()
     }
 }
 
+/*! Finds a window's link in the list that is being cycled through */
+static GList* cycle_list_find(GList *list, ObClient *c)
+{
+    /* windows know where they are in the focus order */
+    if (list == focus_order)
+        return c ? c->focus_order_link : NULL;
+    return g_list_find(list, c);
+}
+
 ObClient* focus_cycle(gboolean forward, gboolean all_desktops,
                       gboolean nonhilite_windows,
                       gboolean dock_windows, gboolean desktop_windows,
@@ -116,9 +125,9 @@ ObClient* focus_cycle(gboolean forward, gboolean all_desktops,
         focus_cycle_nonhilite_windows = nonhilite_windows;
         focus_cycle_dock_windows = dock_windows;
         focus_cycle_desktop_windows = desktop_windows;
-        start = it = g_list_find(list, focus_client);
+        start = it = cycle_list_find(list, focus_client);
     } else
-        start = it = g_list_find(list, focus_cycle_target);
+        start = it = cycle_list_find(list, focus_cycle_target);
 
     if (!start) /* switched desktops or something? */
         start = it = forward ? g_list_last(list) : g_list_first(list);
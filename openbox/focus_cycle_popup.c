@@ -52,12 +52,33 @@
 
 typedef struct _ObFocusCyclePopup       ObFocusCyclePopup;
 typedef struct _ObFocusCyclePopupTarget ObFocusCyclePopupTarget;
+typedef struct _ObFocusCyclePopupCell   ObFocusCyclePopupCell;
+
+/*! A target's icon, drawn over the popup's background, with or without the
+  hilite.  It stays valid while it would be drawn the same way. */
+struct _ObFocusCyclePopupCell
+{
+    Pixmap pixmap;
+    guchar alpha;
+    /* The position of the icon in the background, and the background's size,
+       as the background shows through around the icon */
+    gint x, y;
+    gint bgw, bgh;
+};
 
 struct _ObFocusCyclePopupTarget
 {
     ObClient *client;
     RrImage *icon;
     gchar *text;
+    /* The width of the text, measured when the text changes */
+    gint textw;
+    /* If the target is in the popup's list of targets */
+    gboolean listed;
+    /* The icon drawn without [0] and with [1] the hilite */
+    ObFocusCyclePopupCell cells[2];
+    /* The pixmap that is the iconwin's background */
+    Pixmap iconwin_pixmap;
     Window iconwin;
     /* This is used when the popup is in list mode */
     Window textwin;
@@ -77,6 +98,14 @@ struct _ObFocusCyclePopup
     GList *targets;
     gint n_targets;
 
+    /* The targets for windows which have been in the popup, by their
+       client.  They are kept while the window is managed so that they don't
+       need to be made again each time the popup is shown. */
+    GHashTable *cache;
+    /* Targets whose window went away, kept so their X windows can be used
+       again */
+    GSList *spare_targets;
+
     const ObFocusCyclePopupTarget *last_target;
 
     gint maxtextw;
@@ -107,6 +136,35 @@ static gboolean popup_setup    (ObFocusCyclePopup *p,
 static void     popup_render   (ObFocusCyclePopup *p,
                                 const ObClient *c);
 
+static void popup_target_free_cells(ObFocusCyclePopupTarget *t)
+{
+    gint i;
+
+    for (i = 0; i < 2; ++i)
+        if (t->cells[i].pixmap) {
+            XFreePixmap(obt_display, t->cells[i].pixmap);
+            t->cells[i].pixmap = None;
+        }
+    t->iconwin_pixmap = None;
+}
+
+static void popup_target_free(ObFocusCyclePopupTarget *t)
+{
+    popup_target_free_cells(t);
+    RrImageUnref(t->icon);
+    g_free(t->text);
+    XDestroyWindow(obt_display, t->iconwin);
+    XDestroyWindow(obt_display, t->textwin);
+    g_slice_free(ObFocusCyclePopupTarget, t);
+}
+
+static void popup_target_free_foreach(G_GNUC_UNUSED gpointer key,
+                                      gpointer value,
+                                      G_GNUC_UNUSED gpointer data)
+{
+    popup_target_free(value);
+}
+
 static Window create_window(Window parent, guint bwidth, gulong mask,
                             XSetWindowAttributes *attr)
 {
@@ -163,6 +221,8 @@ void focus_cycle_popup_startup(void)
     popup.targets = NULL;
     popup.n_targets = 0;
     popup.last_target = NULL;
+    popup.cache = g_hash_table_new(g_direct_hash, g_direct_equal);
+    popup.spare_targets = NULL;
 
     /* set up the hilite texture for the icon */
     popup.a_icon->texture[1].data.rgba.width = HILITE_SIZE;
@@ -214,16 +274,15 @@ void focus_cycle_popup_shutdown(void)
     window_remove(popup.bg);
     stacking_remove(INTERNAL_AS_WINDOW(&popup));
 
-    while(popup.targets) {
-        ObFocusCyclePopupTarget *t = popup.targets->data;
-
-        RrImageUnref(t->icon);
-        g_free(t->text);
-        XDestroyWindow(obt_display, t->iconwin);
-        XDestroyWindow(obt_display, t->textwin);
-        g_slice_free(ObFocusCyclePopupTarget, t);
-
-        popup.targets = g_list_delete_link(popup.targets, popup.targets);
+    g_list_free(popup.targets);
+    popup.targets = NULL;
+    g_hash_table_foreach(popup.cache, popup_target_free_foreach, NULL);
+    g_hash_table_destroy(popup.cache);
+    popup.cache = NULL;
+    while (popup.spare_targets) {
+        popup_target_free(popup.spare_targets->data);
+        popup.spare_targets = g_slist_delete_link(popup.spare_targets,
+                                                  popup.spare_targets);
     }
 
     g_free(popup.a_icon->texture[1].data.rgba.data);
@@ -241,38 +300,71 @@ void focus_cycle_popup_shutdown(void)
     RrAppearanceFree(popup.a_bg);
 }
 
-static void popup_target_free(ObFocusCyclePopupTarget *t)
+/*! Returns the target for a window, making it if there isn't one, and
+  brings its text and icon up to date.  Sets changed to TRUE if either of
+  them changed. */
+static ObFocusCyclePopupTarget* popup_target_get(ObFocusCyclePopup *p,
+                                                 ObClient *c,
+                                                 gboolean *changed)
 {
-    RrImageUnref(t->icon);
-    g_free(t->text);
-    XDestroyWindow(obt_display, t->iconwin);
-    XDestroyWindow(obt_display, t->textwin);
-    g_slice_free(ObFocusCyclePopupTarget, t);
+    ObFocusCyclePopupTarget *t;
+    RrImage *icon;
+    gchar *text;
+
+    if (!(t = g_hash_table_lookup(p->cache, c))) {
+        if (p->spare_targets) {
+            t = p->spare_targets->data;
+            p->spare_targets = g_slist_delete_link(p->spare_targets,
+                                                   p->spare_targets);
+        } else {
+            t = g_slice_new0(ObFocusCyclePopupTarget);
+            t->iconwin = create_window(p->bg, 0, 0, NULL);
+            t->textwin = create_window(p->bg, 0, 0, NULL);
+        }
+        t->client = c;
+        t->text = NULL;
+        t->textw = 0;
+        t->icon = NULL;
+        t->listed = FALSE;
+        g_hash_table_insert(p->cache, c, t);
+    }
+
+    /* only measure the text when it changes */
+    text = popup_get_name(c);
+    if (t->text && !strcmp(t->text, text))
+        g_free(text);
+    else {
+        g_free(t->text);
+        t->text = text;
+        p->a_text->texture[0].data.text.string = text;
+        t->textw = RrMinWidth(p->a_text);
+        *changed = TRUE;
+    }
+
+    icon = client_icon(c);
+    if (icon != t->icon) {
+        RrImageRef(icon); /* own the icon so it won't go away */
+        RrImageUnref(t->icon);
+        t->icon = icon;
+        popup_target_free_cells(t);
+        *changed = TRUE;
+    }
+
+    return t;
 }
 
 static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
                             gboolean refresh_targets, gboolean linear)
 {
     gint maxwidth, n;
-    GList *it;
-    GList *rtargets; /* old targets for refresh */
-    GList *rtlast;
+    GList *it, *oit;
+    GList *old; /* old targets for refresh */
     gboolean change;
 
-    if (refresh_targets) {
-        rtargets = p->targets;
-        rtlast = g_list_last(rtargets);
-        p->targets = NULL;
-        p->n_targets = 0;
-        change = FALSE;
-    }
-    else {
-        rtargets = rtlast = NULL;
-        change = TRUE;
-    }
-
-    g_assert(p->targets == NULL);
-    g_assert(p->n_targets == 0);
+    old = p->targets;
+    p->targets = NULL;
+    p->n_targets = 0;
+    change = !refresh_targets;
 
     /* make its width to be the width of all the possible titles */
 
@@ -287,62 +379,38 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
         ObClient *ft = it->data;
 
         if (focus_cycle_valid(ft)) {
-            GList *rit;
-
-            /* reuse the target if possible during refresh */
-            for (rit = rtlast; rit; rit = g_list_previous(rit)) {
-                ObFocusCyclePopupTarget *t = rit->data;
-                if (t->client == ft) {
-                    if (rit == rtlast)
-                        rtlast = g_list_previous(rit);
-                    rtargets = g_list_remove_link(rtargets, rit);
-
-                    p->targets = g_list_concat(rit, p->targets);
-                    ++n;
-
-                    if (rit != rtlast)
-                        change = TRUE; /* order changed */
-                    break;
-                }
-            }
+            ObFocusCyclePopupTarget *t;
 
-            if (!rit) {
-                gchar *text = popup_get_name(ft);
-
-                /* measure */
-                p->a_text->texture[0].data.text.string = text;
-                maxwidth = MAX(maxwidth, RrMinWidth(p->a_text));
-
-                if (!create_targets) {
-                    g_free(text);
-                } else {
-                    ObFocusCyclePopupTarget *t =
-                        g_slice_new(ObFocusCyclePopupTarget);
+            t = popup_target_get(p, ft, &change);
+            maxwidth = MAX(maxwidth, t->textw);
 
-                    t->client = ft;
-                    t->text = text;
-                    t->icon = client_icon(t->client);
-                    RrImageRef(t->icon); /* own the icon so it won't go away */
-                    t->iconwin = create_window(p->bg, 0, 0, NULL);
-                    t->textwin = create_window(p->bg, 0, 0, NULL);
-
-                    p->targets = g_list_prepend(p->targets, t);
-                    ++n;
-
-                    change = TRUE; /* added a window */
-                }
+            if (create_targets) {
+                p->targets = g_list_prepend(p->targets, t);
+                ++n;
             }
         }
     }
 
-    if (rtargets) {
-        change = TRUE; /* removed a window */
+    /* see if any windows were added, removed or moved */
+    for (it = p->targets, oit = old; it && oit && it->data == oit->data;
+         it = g_list_next(it), oit = g_list_next(oit));
+    if (it || oit) {
+        change = TRUE;
 
-        while (rtargets) {
-            popup_target_free(rtargets->data);
-            rtargets = g_list_delete_link(rtargets, rtargets);
+        for (oit = old; oit; oit = g_list_next(oit))
+            ((ObFocusCyclePopupTarget*)oit->data)->listed = FALSE;
+        for (it = p->targets; it; it = g_list_next(it))
+            ((ObFocusCyclePopupTarget*)it->data)->listed = TRUE;
+        /* hide the windows for the targets that are gone from the list */
+        for (oit = old; oit; oit = g_list_next(oit)) {
+            ObFocusCyclePopupTarget *t = oit->data;
+            if (!t->listed) {
+                XUnmapWindow(obt_display, t->iconwin);
+                XUnmapWindow(obt_display, t->textwin);
+            }
         }
     }
+    g_list_free(old);
 
     p->n_targets = n;
     if (refresh_targets)
@@ -356,14 +424,45 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
 
 static void popup_cleanup(void)
 {
-    while(popup.targets) {
-        popup_target_free(popup.targets->data);
-        popup.targets = g_list_delete_link(popup.targets, popup.targets);
-    }
+    GList *it;
+
+    /* keep the targets for next time, but hide all their windows */
+    XUnmapSubwindows(obt_display, popup.bg);
+
+    for (it = popup.targets; it; it = g_list_next(it))
+        ((ObFocusCyclePopupTarget*)it->data)->listed = FALSE;
+    g_list_free(popup.targets);
+    popup.targets = NULL;
     popup.n_targets = 0;
     popup.last_target = NULL;
 }
 
+void focus_cycle_popup_forget(ObClient *c)
+{
+    ObFocusCyclePopupTarget *t;
+
+    if (!popup.cache || !(t = g_hash_table_lookup(popup.cache, c))) return;
+
+    g_hash_table_remove(popup.cache, c);
+    if (t->listed) {
+        popup.targets = g_list_remove(popup.targets, t);
+        --popup.n_targets;
+        if (popup.last_target == t)
+            popup.last_target = NULL;
+    }
+
+    /* keep the windows to use for another target */
+    XUnmapWindow(obt_display, t->iconwin);
+    XUnmapWindow(obt_display, t->textwin);
+    popup_target_free_cells(t);
+    RrImageUnref(t->icon);
+    g_free(t->text);
+    t->icon = NULL;
+    t->text = NULL;
+    t->client = NULL;
+    popup.spare_targets = g_slist_prepend(popup.spare_targets, t);
+}
+
 static gchar *popup_get_name(ObClient *c)
 {
     ObClient *p;
@@ -391,6 +490,62 @@ static gchar *popup_get_name(ObClient *c)
     return ret;
 }
 
+/*! Shows a target's icon at a position in the background.  The icon is only
+  drawn if it has not been drawn the same way before, otherwise the pixmap
+  from then is used again. */
+static void popup_draw_icon(ObFocusCyclePopup *p, ObFocusCyclePopupTarget *t,
+                            gboolean hilite, gint x, gint y, gint bgw, gint bgh)
+{
+    ObFocusCyclePopupCell *cell = &t->cells[hilite ? 1 : 0];
+    const guchar alpha = t->client->iconic ? OB_ICONIC_ALPHA : 0xff;
+
+    if (!cell->pixmap || cell->alpha != alpha || cell->x != x ||
+        cell->y != y || cell->bgw != bgw || cell->bgh != bgh)
+    {
+        Pixmap oldp;
+
+        /* get the icon from the client */
+        p->a_icon->texture[0].data.image.twidth = ICON_SIZE;
+        p->a_icon->texture[0].data.image.theight = ICON_SIZE;
+        p->a_icon->texture[0].data.image.tx = HILITE_OFFSET;
+        p->a_icon->texture[0].data.image.ty = HILITE_OFFSET;
+        p->a_icon->texture[0].data.image.alpha = alpha;
+        p->a_icon->texture[0].data.image.image = t->icon;
+
+        /* Draw the hilite? */
+        p->a_icon->texture[1].type = hilite ? RR_TEXTURE_RGBA : RR_TEXTURE_NONE;
+
+        /* draw the icon */
+        p->a_icon->surface.parentx = x;
+        p->a_icon->surface.parenty = y;
+        oldp = RrPaintPixmap(p->a_icon, HILITE_SIZE, HILITE_SIZE);
+        if (oldp) XFreePixmap(obt_display, oldp);
+
+        /* keep the pixmap, rather than letting the appearance free it the
+           next time it draws */
+        if (cell->pixmap) {
+            if (t->iconwin_pixmap == cell->pixmap)
+                t->iconwin_pixmap = None;
+            XFreePixmap(obt_display, cell->pixmap);
+        }
+        cell->pixmap = RrTakePixmap(p->a_icon);
+
+        cell->alpha = alpha;
+        cell->x = x;
+        cell->y = y;
+        cell->bgw = bgw;
+        cell->bgh = bgh;
+    }
+
+    /* the window keeps its background while it is hidden, so there is
+       nothing to do if it already has this one */
+    if (t->iconwin_pixmap != cell->pixmap) {
+        XSetWindowBackgroundPixmap(obt_display, t->iconwin, cell->pixmap);
+        XClearWindow(obt_display, t->iconwin);
+        t->iconwin_pixmap = cell->pixmap;
+    }
+}
+
 static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
 {
     gint ml, mt, mr, mb;
@@ -610,7 +765,7 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
 
     /* draw the icons and text */
     for (i = 0, it = p->targets; it; ++i, it = g_list_next(it)) {
-        const ObFocusCyclePopupTarget *target = it->data;
+        ObFocusCyclePopupTarget *target = it->data;
 
         /* have to redraw the targetted icon and last targetted icon
          * to update the hilite */
@@ -661,23 +816,9 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
                     XMapWindow(obt_display, target->iconwin);
             }
 
-            /* get the icon from the client */
-            p->a_icon->texture[0].data.image.twidth = ICON_SIZE;
-            p->a_icon->texture[0].data.image.theight = ICON_SIZE;
-            p->a_icon->texture[0].data.image.tx = HILITE_OFFSET;
-            p->a_icon->texture[0].data.image.ty = HILITE_OFFSET;
-            p->a_icon->texture[0].data.image.alpha =
-                target->client->iconic ? OB_ICONIC_ALPHA : 0xff;
-            p->a_icon->texture[0].data.image.image = target->icon;
-
-            /* Draw the hilite? */
-            p->a_icon->texture[1].type = (target == newtarget) ?
-                RR_TEXTURE_RGBA : RR_TEXTURE_NONE;
-
             /* draw the icon */
-            p->a_icon->surface.parentx = iconx;
-            p->a_icon->surface.parenty = icony;
-            RrPaint(p->a_icon, target->iconwin, HILITE_SIZE, HILITE_SIZE);
+            popup_draw_icon(p, target, target == newtarget,
+                            iconx, icony, w, h);
 
             /* draw the text */
             if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST ||
@@ -783,13 +924,8 @@ void focus_cycle_popup_single_hide(void)
 gboolean focus_cycle_popup_is_showing(ObClient *c)
 {
     if (popup.mapped) {
-        GList *it;
-
-        for (it = popup.targets; it; it = g_list_next(it)) {
-            ObFocusCyclePopupTarget *t = it->data;
-            if (t->client == c)
-                return TRUE;
-        }
+        ObFocusCyclePopupTarget *t = g_hash_table_lookup(popup.cache, c);
+        return t && t->listed;
     }
     return FALSE;
 }
@@ -42,6 +42,10 @@ void focus_cycle_popup_single_hide(void);
 
 gboolean focus_cycle_popup_is_showing(struct _ObClient *c);
 
+/*! Frees what the popup keeps for a window.  Call this when the window is
+  unmanaged. */
+void focus_cycle_popup_forget(struct _ObClient *c);
+
 /*! Redraws the focus cycle popup, and returns the current target.  If
     the target given to the function is no longer valid, this will return
     a different target that is valid, and which should be considered the
@@ -28,6 +28,7 @@
 #include "focus_cycle_indicator.h"
 #include "moveresize.h"
 #include "screen.h"
+#include "metrics.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
@@ -73,6 +74,7 @@ static Visual *check_32bit_client(ObClient *c)
     if (RrDepth(ob_rr_inst) == 32)
         return NULL;
 
+    metrics_round_trip();
     ret = XGetWindowAttributes(obt_display, c->window, &wattrib);
     g_assert(ret != BadDrawable);
     g_assert(ret != BadWindow);
@@ -225,6 +227,7 @@ static void set_theme_statics(ObFrame *self)
 
 void frame_free(ObFrame *self)
 {
+    framerender_forget(self);
     XDestroyWindow(obt_display, self->window);
     if (self->colormap)
         XFreeColormap(obt_display, self->colormap);
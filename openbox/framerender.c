@@ -23,6 +23,7 @@
 #include "client.h"
 #include "framerender.h"
 #include "obrender/theme.h"
+#include "obt/trace.h"
 
 static void framerender_label(ObFrame *self, RrAppearance *a);
 static void framerender_icon(ObFrame *self, RrAppearance *a);
@@ -32,16 +33,51 @@ static void framerender_desk(ObFrame *self, RrAppearance *a);
 static void framerender_shade(ObFrame *self, RrAppearance *a);
 static void framerender_close(ObFrame *self, RrAppearance *a);
 
+/*! When more than 0, frames are not drawn, but are kept in frozen_frames */
+static guint freeze = 0;
+static GSList *frozen_frames = NULL;
+
+void framerender_freeze(void)
+{
+    ++freeze;
+}
+
+void framerender_thaw(void)
+{
+    g_assert(freeze > 0);
+
+    if (--freeze) return;
+
+    while (frozen_frames) {
+        ObFrame *f = frozen_frames->data;
+
+        frozen_frames = g_slist_delete_link(frozen_frames, frozen_frames);
+        framerender_frame(f);
+    }
+}
+
+void framerender_forget(ObFrame *self)
+{
+    frozen_frames = g_slist_remove(frozen_frames, self);
+}
+
 void framerender_frame(ObFrame *self)
 {
     if (frame_iconify_animating(self))
         return; /* delay redrawing until the animation is done */
     if (!self->need_render)
         return;
+    if (freeze) {
+        if (!g_slist_find(frozen_frames, self))
+            frozen_frames = g_slist_prepend(frozen_frames, self);
+        return;
+    }
     if (!self->visible)
         return;
     self->need_render = FALSE;
 
+    OBT_TRACE_BEGIN("framerender_frame");
+
     {
         gulong px;
 
@@ -346,6 +382,8 @@ void framerender_frame(ObFrame *self)
     }
 
     XFlush(obt_display);
+
+    OBT_TRACE_END("framerender_frame");
 }
 
 static void framerender_label(ObFrame *self, RrAppearance *a)
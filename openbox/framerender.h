@@ -23,4 +23,11 @@ struct _ObFrame;
 
 void framerender_frame(struct _ObFrame *self);
 
+/*! Holds back redrawing frames until framerender_thaw is called the same
+  number of times, so a frame which changes many times is drawn once */
+void framerender_freeze(void);
+void framerender_thaw(void);
+/*! Forgets about a frame which was waiting to be redrawn */
+void framerender_forget(struct _ObFrame *self);
+
 #endif
@@ -22,6 +22,7 @@
 #include "event.h"
 #include "screen.h"
 #include "debug.h"
+#include "metrics.h"
 #include "obt/display.h"
 #include "obt/keyboard.h"
 
@@ -139,6 +140,7 @@ gint grab_server(gboolean grab)
     if (grab) {
         if (sgrabs++ == 0) {
             XGrabServer(obt_display);
+            metrics_round_trip();
             XSync(obt_display, FALSE);
         }
     } else if (sgrabs > 0) {
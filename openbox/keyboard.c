@@ -242,38 +242,35 @@ gboolean keyboard_event(ObClient *client, const XEvent *e)
         p = keyboard_firstnode;
     else
         p = curpos->first_child;
-    while (p) {
-        if (p->key == e->xkey.keycode && p->state == mods) {
-            /* if we hit a key binding, then close any open menus and run it */
-            if (menu_frame_visible)
-                menu_frame_hide_all();
-
-            if (p->first_child != NULL) { /* part of a chain */
-                if (chain_timer) g_source_remove(chain_timer);
-                /* 3 second timeout for chains */
-                chain_timer =
-                    g_timeout_add_full(G_PRIORITY_DEFAULT,
-                                       3000, chain_timeout, NULL,
-                                       chain_done);
-                set_curpos(p);
-            } else if (p->chroot)         /* an empty chroot */
-                set_curpos(p);
-            else {
-                GSList *it;
-
-                for (it = p->actions; it; it = g_slist_next(it))
-                    if (actions_act_is_interactive(it->data)) break;
-                if (it == NULL) /* reset if the actions are not interactive */
-                    keyboard_reset_chains(0);
-
-                actions_run_acts(p->actions, OB_USER_ACTION_KEYBOARD_KEY,
-                                 e->xkey.state, e->xkey.x_root, e->xkey.y_root,
-                                 0, OB_FRAME_CONTEXT_NONE, client);
-            }
-            used = TRUE;
-            break;
+    p = tree_level_find(p, mods, e->xkey.keycode);
+    if (p) {
+        /* if we hit a key binding, then close any open menus and run it */
+        if (menu_frame_visible)
+            menu_frame_hide_all();
+
+        if (p->first_child != NULL) { /* part of a chain */
+            if (chain_timer) g_source_remove(chain_timer);
+            /* 3 second timeout for chains */
+            chain_timer =
+                g_timeout_add_full(G_PRIORITY_DEFAULT,
+                                   3000, chain_timeout, NULL,
+                                   chain_done);
+            set_curpos(p);
+        } else if (p->chroot)         /* an empty chroot */
+            set_curpos(p);
+        else {
+            GSList *it;
+
+            for (it = p->actions; it; it = g_slist_next(it))
+                if (actions_act_is_interactive(it->data)) break;
+            if (it == NULL) /* reset if the actions are not interactive */
+                keyboard_reset_chains(0);
+
+            actions_run_acts(p->actions, OB_USER_ACTION_KEYBOARD_KEY,
+                             e->xkey.state, e->xkey.x_root, e->xkey.y_root,
+                             0, OB_FRAME_CONTEXT_NONE, client);
         }
-        p = p->next_sibling;
+        used = TRUE;
     }
     return used;
 }
@@ -321,19 +318,27 @@ void keyboard_rebind(void)
     grab_keys(TRUE);
 }
 
-void keyboard_startup(void)
+void keyboard_startup(gboolean reconfig)
 {
-    grab_keys(TRUE);
     popup = popup_new();
     popup_set_text_align(popup, RR_JUSTIFY_CENTER);
+
+    if (reconfig)
+        /* the keymap may have changed, so translate the bindings again */
+        keyboard_rebind();
+    else
+        grab_keys(TRUE);
 }
 
-void keyboard_shutdown(void)
+void keyboard_shutdown(gboolean reconfig)
 {
     if (chain_timer) g_source_remove(chain_timer);
 
-    keyboard_unbind_all();
     set_curpos(NULL);
+    /* the bindings are kept through a reconfigure, and only replaced if the
+       config file has new ones */
+    if (!reconfig)
+        keyboard_unbind_all();
 
     popup_free(popup);
     popup = NULL;
@@ -39,6 +39,8 @@ void tree_destroy(KeyBindingTree *tree)
                 actions_act_unref(sit->data);
             g_slist_free(tree->actions);
         }
+        if (tree->level_index)
+            g_hash_table_destroy(tree->level_index);
         g_slice_free(KeyBindingTree, tree);
         tree = c;
     }
@@ -68,40 +70,72 @@ KeyBindingTree *tree_build(GList *keylist)
     return ret;
 }
 
+/* the key for a binding in its level's index */
+#define LEVEL_KEY(state, key) \
+    GUINT_TO_POINTER(((state) << 16) | ((key) & 0xffff))
+
+KeyBindingTree *tree_level_find(KeyBindingTree *first, guint state, guint key)
+{
+    /* bindings that didn't get translated are not in the index */
+    if (key && first && first->level_index)
+        return g_hash_table_lookup(first->level_index, LEVEL_KEY(state, key));
+
+    for (; first; first = first->next_sibling)
+        if (first->state == state && first->key == key)
+            return first;
+    return NULL;
+}
+
+static void level_index_add(KeyBindingTree *first, KeyBindingTree *node)
+{
+    KeyBindingTree *p;
+
+    if (!first->level_index) {
+        first->level_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+        p = first;
+    } else
+        p = node;
+
+    /* keep the first binding for a key, as that is the one that a search
+       through the level would find */
+    for (; p; p = p->next_sibling) {
+        gpointer k = LEVEL_KEY(p->state, p->key);
+
+        if (p->key && !g_hash_table_lookup(first->level_index, k))
+            g_hash_table_insert(first->level_index, k, p);
+    }
+}
+
 void tree_assimilate(KeyBindingTree *node)
 {
-    KeyBindingTree *a, *b, *tmp, *last;
+    KeyBindingTree *a, *b, *tmp, *first, *last;
 
     if (keyboard_firstnode == NULL) {
         /* there are no nodes at this level yet */
         keyboard_firstnode = node;
-    } else {
-        a = keyboard_firstnode;
-        last = a;
-        b = node;
-        while (a) {
-            last = a;
-            /* check b->key != 0 for key bindings that didn't get translated */
-            if (!(a->state == b->state && a->key == b->key && b->key != 0)) {
-                a = a->next_sibling;
-            } else {
-                tmp = b;
-                b = b->first_child;
-                g_slice_free(KeyBindingTree, tmp);
-                a = a->first_child;
-            }
-        }
-        /* check b->key != 0, and save key bindings that didn't get translated
-           as siblings here */
-        if (!(last->state == b->state && last->key == b->key && b->key != 0)) {
-            last->next_sibling = b;
-            b->parent = last->parent;
-        } else {
-            last->first_child = b->first_child;
-            last->first_child->parent = last;
-            g_slice_free(KeyBindingTree, b);
-        }
+        return;
     }
+
+    first = keyboard_firstnode;
+    b = node;
+    /* check b->key != 0 for key bindings that didn't get translated, and
+       save them as siblings */
+    while (b->key && (a = tree_level_find(first, b->state, b->key))) {
+        tmp = b;
+        b = b->first_child;
+        g_slice_free(KeyBindingTree, tmp);
+
+        if (!b) return; /* it was all in the tree already */
+        if (!a->first_child) break;
+        first = a->first_child;
+    }
+
+    /* add the rest of the chain to the end of this level */
+    last = first->level_last ? first->level_last : first;
+    last->next_sibling = b;
+    b->parent = last->parent;
+    first->level_last = b;
+    level_index_add(first, b);
 }
 
 KeyBindingTree *tree_find(KeyBindingTree *search, gboolean *conflict)
@@ -116,21 +150,22 @@ KeyBindingTree *tree_find(KeyBindingTree *search, gboolean *conflict)
         /* check b->key != 0 for key bindings that didn't get translated, and
            don't make them conflict with anything else so that they can all
            live together in peace and harmony */
-        if (!(a->state == b->state && a->key == b->key && b->key != 0)) {
-            a = a->next_sibling;
-        } else {
-            if ((a->first_child == NULL) == (b->first_child == NULL)) {
-                if (a->first_child == NULL) {
-                    /* found it! (return the actual node, not the search's) */
-                    return a;
-                }
-            } else {
-                *conflict = TRUE;
-                return NULL; /* the chain status' don't match (conflict!) */
+        if (!b->key)
+            return NULL;
+        if (!(a = tree_level_find(a, b->state, b->key)))
+            return NULL;
+
+        if ((a->first_child == NULL) == (b->first_child == NULL)) {
+            if (a->first_child == NULL) {
+                /* found it! (return the actual node, not the search's) */
+                return a;
             }
-            b = b->first_child;
-            a = a->first_child;
+        } else {
+            *conflict = TRUE;
+            return NULL; /* the chain status' don't match (conflict!) */
         }
+        b = b->first_child;
+        a = a->first_child;
     }
     return NULL; /* it just isn't in here */
 }
@@ -139,8 +174,7 @@ gboolean tree_chroot(KeyBindingTree *tree, GList *keylist)
 {
     guint key, state;
     translate_key(keylist->data, &state, &key);
-    while (tree != NULL && !(tree->state == state && tree->key == key))
-        tree = tree->next_sibling;
+    tree = tree_level_find(tree, state, key);
     if (tree != NULL) {
         if (keylist->next == NULL) {
             tree->chroot = TRUE;
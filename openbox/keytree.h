@@ -34,12 +34,22 @@ typedef struct KeyBindingTree {
     struct KeyBindingTree *next_sibling;
     /* the first child of this binding (next binding in a chained sequence).*/
     struct KeyBindingTree *first_child;
+
+    /* these are only used in the first binding at each level */
+    /* the bindings at this level by their state and key, once there is more
+       than one of them */
+    GHashTable *level_index;
+    /* the last binding at this level, or NULL if this is the only one */
+    struct KeyBindingTree *level_last;
 } KeyBindingTree;
 
 void tree_destroy(KeyBindingTree *tree);
 KeyBindingTree *tree_build(GList *keylist);
 void tree_assimilate(KeyBindingTree *node);
 KeyBindingTree *tree_find(KeyBindingTree *search, gboolean *conflict);
+/*! Finds the binding for a state and key at the level which begins with
+  first */
+KeyBindingTree *tree_level_find(KeyBindingTree *first, guint state, guint key);
 gboolean tree_chroot(KeyBindingTree *tree, GList *keylist);
 
 #endif
@@ -37,7 +37,20 @@
 #include "obt/xml.h"
 #include "obt/paths.h"
 
+#ifdef HAVE_UNISTD_H
+#  include <sys/types.h>
+#  include <unistd.h> /* for setpgid() */
+#endif
+
+#ifdef HAVE_SIGNAL_H
+#  include <signal.h> /* for kill() */
+#endif
+
+/* how long to wait for a pipe-menu's command to give its output */
+#define PIPE_MENU_TIMEOUT 10000 /* milliseconds */
+
 typedef struct _ObMenuParseState ObMenuParseState;
+typedef struct _ObMenuPipe ObMenuPipe;
 
 struct _ObMenuParseState
 {
@@ -45,24 +58,119 @@ struct _ObMenuParseState
     ObMenu *pipe_creator;
 };
 
+struct _ObMenuPipe
+{
+    /* The menu being filled */
+    ObMenu *menu;
+    /* The running command, which openbox's SIGCHLD handler reaps.  It leads
+       its own process group */
+    GPid pid;
+
+    GIOChannel *channel;
+    guint read_id;
+    guint timeout_id;
+    ObtXmlPush *parser;
+
+    /* Shown in the menu until the command's output has been parsed, or NULL
+       if the menu is showing its cached entries while they are refreshed */
+    ObMenuEntry *loading;
+};
+
 static GHashTable *menu_hash = NULL;
 static ObtXmlInst *menu_parse_inst;
 static ObMenuParseState menu_parse_state;
 static gboolean menu_can_hide = FALSE;
 static guint menu_timeout_id = 0;
+/* a checksum of the menu files, from when they were last parsed */
+static gchar *menu_files_sum = NULL;
 
 static void menu_destroy_hash_value(ObMenu *self);
 static void parse_menu_item(xmlNodePtr node, gpointer data);
 static void parse_menu_separator(xmlNodePtr node, gpointer data);
 static void parse_menu(xmlNodePtr node, gpointer data);
+static void clear_entries(ObMenu *self);
 static gunichar parse_shortcut(const gchar *label, gboolean allow_shortcut,
                                gchar **strippedlabel, guint *position,
                                gboolean *always_show);
 
-void menu_startup(gboolean reconfig)
+/*! Loads a menu file, and parses it if @parse is TRUE.  Adds its contents to
+  the checksum @sum. */
+static gboolean load_menu_file(const gchar *file, gboolean parse,
+                               GChecksum *sum)
+{
+    if (!obt_xml_load_config_file(menu_parse_inst, "openbox", file,
+                                  "openbox_menu") &&
+        !obt_xml_load_file(menu_parse_inst, file, "openbox_menu"))
+    {
+        return FALSE;
+    }
+
+    obt_xml_checksum_node(sum, obt_xml_root(menu_parse_inst));
+    if (parse)
+        obt_xml_tree_from_root(menu_parse_inst);
+    obt_xml_close(menu_parse_inst);
+    return TRUE;
+}
+
+/*! Loads the user's menu files, and parses them if @parse is TRUE.  Returns a
+  checksum of their contents, to tell if they changed since the last time. */
+static gchar* load_menu_files(gboolean parse)
 {
+    GChecksum *sum;
     gboolean loaded = FALSE;
     GSList *it;
+    gchar *r;
+
+    sum = g_checksum_new(G_CHECKSUM_SHA1);
+
+    for (it = config_menu_files; it; it = g_slist_next(it)) {
+        if (load_menu_file(it->data, parse, sum))
+            loaded = TRUE;
+        else if (parse)
+            g_message(_("Unable to find a valid menu file \"%s\""),
+                      (const gchar*)it->data);
+    }
+    if (!loaded) {
+        if (!load_menu_file("menu.xml", parse, sum) && parse)
+            g_message(_("Unable to find a valid menu file \"%s\""),
+                      "menu.xml");
+    }
+
+    r = g_strdup(g_checksum_get_string(sum));
+    g_checksum_free(sum);
+    return r;
+}
+
+static void destroy_menus(gboolean reconfig)
+{
+    obt_xml_instance_unref(menu_parse_inst);
+    menu_parse_inst = NULL;
+
+    client_list_combined_menu_shutdown(reconfig);
+    client_list_menu_shutdown(reconfig);
+
+    g_hash_table_destroy(menu_hash);
+    menu_hash = NULL;
+}
+
+void menu_startup(gboolean reconfig)
+{
+    if (reconfig) {
+        /* keep the menus we have if nothing they are made from changed,
+           which also keeps the pipe menus' cached output.  the client menus
+           hold masks and colors from the theme, so a new theme needs new
+           menus */
+        if (!(config_changed & (OB_CONFIG_SECTION_MENU |
+                                OB_CONFIG_SECTION_THEME)))
+        {
+            gchar *sum = load_menu_files(FALSE);
+            gboolean same = !strcmp(sum, menu_files_sum);
+
+            g_free(sum);
+            if (same) return;
+        }
+        destroy_menus(reconfig);
+    }
 
     menu_hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
                                       (GDestroyNotify)menu_destroy_hash_value);
@@ -72,6 +180,7 @@ void menu_startup(gboolean reconfig)
     client_menu_startup();
 
     menu_parse_inst = obt_xml_instance_new();
+    obt_xml_instance_set_cache(menu_parse_inst, TRUE);
 
     menu_parse_state.parent = NULL;
     menu_parse_state.pipe_creator = NULL;
@@ -81,108 +190,354 @@ void menu_startup(gboolean reconfig)
     obt_xml_register(menu_parse_inst, "separator",
                        parse_menu_separator, &menu_parse_state);
 
-    for (it = config_menu_files; it; it = g_slist_next(it)) {
-        if (obt_xml_load_config_file(menu_parse_inst,
-                                     "openbox",
-                                     it->data,
-                                     "openbox_menu"))
-        {
-            loaded = TRUE;
-            obt_xml_tree_from_root(menu_parse_inst);
-            obt_xml_close(menu_parse_inst);
-        }
-        else if (obt_xml_load_file(menu_parse_inst,
-                                   it->data,
-                                   "openbox_menu"))
-        {
-            loaded = TRUE;
-            obt_xml_tree_from_root(menu_parse_inst);
-            obt_xml_close(menu_parse_inst);
-        }
-        else
-            g_message(_("Unable to find a valid menu file \"%s\""),
-                      (const gchar*)it->data);
-    }
-    if (!loaded) {
-        if (obt_xml_load_config_file(menu_parse_inst,
-                                     "openbox",
-                                     "menu.xml",
-                                     "openbox_menu"))
-        {
-            obt_xml_tree_from_root(menu_parse_inst);
-            obt_xml_close(menu_parse_inst);
-        } else
-            g_message(_("Unable to find a valid menu file \"%s\""),
-                      "menu.xml");
-    }
+    g_free(menu_files_sum);
+    menu_files_sum = load_menu_files(TRUE);
 
     g_assert(menu_parse_state.parent == NULL);
 }
 
 void menu_shutdown(gboolean reconfig)
 {
-    obt_xml_instance_unref(menu_parse_inst);
-    menu_parse_inst = NULL;
-
     menu_frame_hide_all();
 
-    client_list_combined_menu_shutdown(reconfig);
-    client_list_menu_shutdown(reconfig);
+    /* on reconfigure, menu_startup() decides if the menus need to be
+       loaded again */
+    if (reconfig) return;
 
-    g_hash_table_destroy(menu_hash);
-    menu_hash = NULL;
+    destroy_menus(reconfig);
+
+    g_free(menu_files_sum);
+    menu_files_sum = NULL;
 }
 
-static gboolean menu_pipe_submenu(G_GNUC_UNUSED gpointer key, gpointer val, G_GNUC_UNUSED gpointer data)
+/*! Stop reading the command's output and detach it from its menu.
+  @param kill_child If the command should be stopped if it is still running
+*/
+static void pipe_detach(ObMenuPipe *p, gboolean kill_child)
+{
+    if (p->read_id) g_source_remove(p->read_id);
+    if (p->timeout_id) g_source_remove(p->timeout_id);
+    g_io_channel_unref(p->channel);
+    obt_xml_push_free(p->parser);
+
+    if (p->loading)
+        menu_entry_remove(p->loading);
+    p->menu->pipe = NULL;
+
+    /* the command may have exited and been reaped already, and its pid used
+       again by another process, so signal its process group instead.  the
+       group is only gone once everything the command started has exited */
+    if (kill_child)
+        kill(-p->pid, SIGTERM);
+    g_slice_free(ObMenuPipe, p);
+}
+
+static gboolean pipe_cache_stale(ObMenu *menu)
 {
+    return (g_get_monotonic_time() - menu->pipe_time >=
+            (gint64)menu->pipe_ttl * G_USEC_PER_SEC);
+}
+
+/*! Returns TRUE if the menu's entries should be kept for the next time it is
+  shown, rather than being thrown away when menus are shown again */
+static gboolean pipe_cache_kept(ObMenu *menu)
+{
+    /* menus made by a pipe menu only live as long as its entries do */
+    if (menu->pipe_creator && !pipe_cache_kept(menu->pipe_creator))
+        return FALSE;
+    if (!menu->execute)
+        return TRUE;
+    if (!menu->entries)
+        return FALSE;
+    /* stale entries are shown until they are refreshed in the background */
+    if (menu->pipe_refresh_background)
+        return TRUE;
+    return menu->pipe_ttl > 0 && !pipe_cache_stale(menu);
+}
+
+static gboolean pipe_created_by(ObMenu *menu, ObMenu *creator)
+{
+    ObMenu *m;
+
+    for (m = menu->pipe_creator; m; m = m->pipe_creator)
+        if (m == creator)
+            return TRUE;
+    return FALSE;
+}
+
+static void find_created_by(G_GNUC_UNUSED gpointer key, gpointer val,
+                            gpointer data)
+{
+    GSList **list = data;
     ObMenu *menu = val;
-    return menu->pipe_creator != NULL;
+    ObMenu *creator = (*list)->data;
+
+    if (pipe_created_by(menu, creator))
+        *list = g_slist_append(*list, menu);
 }
 
-static void clear_cache(G_GNUC_UNUSED gpointer key, gpointer val, G_GNUC_UNUSED gpointer data)
+static void find_uncached(G_GNUC_UNUSED gpointer key, gpointer val,
+                          gpointer data)
 {
+    GSList **list = data;
     ObMenu *menu = val;
-    if (menu->execute)
+
+    if (menu->pipe_creator && !pipe_cache_kept(menu->pipe_creator))
+        *list = g_slist_prepend(*list, menu);
+}
+
+static void clear_cache(G_GNUC_UNUSED gpointer key, gpointer val,
+                        G_GNUC_UNUSED gpointer data)
+{
+    ObMenu *menu = val;
+
+    if (menu->execute && !pipe_cache_kept(menu)) {
+        if (menu->pipe)
+            pipe_detach(menu->pipe, TRUE);
         menu_clear_entries(menu);
+    }
 }
 
 void menu_clear_pipe_caches(void)
 {
-    /* delete any pipe menus' submenus */
-    g_hash_table_foreach_remove(menu_hash, menu_pipe_submenu, NULL);
+    GSList *dead = NULL;
+
+    /* delete any pipe menus' submenus, unless the pipe menu is keeping its
+       entries.  find them all first, since whether a menu is kept depends on
+       the menus that created it */
+    g_hash_table_foreach(menu_hash, find_uncached, &dead);
+    while (dead) {
+        menu_free(dead->data);
+        dead = g_slist_delete_link(dead, dead);
+    }
     /* empty the top level pipe menus */
     g_hash_table_foreach(menu_hash, clear_cache, NULL);
 }
 
-void menu_pipe_execute(ObMenu *self)
+static void drop_icon(G_GNUC_UNUSED gpointer key, gpointer val, gpointer data)
 {
-    gchar *output;
-    GError *err = NULL;
+    ObMenu *menu = val;
+    GList *it;
 
-    if (!self->execute)
-        return;
-    if (self->entries) /* the entries are already created and cached */
-        return;
+    for (it = menu->entries; it; it = g_list_next(it)) {
+        ObMenuEntry *e = it->data;
+
+        if (e->type == OB_MENU_ENTRY_TYPE_NORMAL &&
+            e->data.normal.icon == data)
+        {
+            RrImageUnref(e->data.normal.icon);
+            e->data.normal.icon = NULL;
+        }
+        else if (e->type == OB_MENU_ENTRY_TYPE_SUBMENU &&
+                 e->data.submenu.icon == data)
+        {
+            RrImageUnref(e->data.submenu.icon);
+            e->data.submenu.icon = NULL;
+        }
+    }
+}
+
+void menu_drop_icon(RrImage *icon)
+{
+    g_hash_table_foreach(menu_hash, drop_icon, icon);
+}
+
+/*! Throw away the entries of a pipe menu which is being refreshed, along with
+  any menus that were made by it */
+static void pipe_drop_contents(ObMenu *self)
+{
+    GSList *dead;
+    GList *it;
+
+    /* the submenus from the menu may be open, and so may the frames showing
+       the entries that did not fit in it.  those are all below the first
+       frame opened for the menu, which is refreshed once the new entries
+       are in */
+    for (it = g_list_last(menu_frame_visible); it; it = g_list_previous(it)) {
+        ObMenuFrame *f = it->data;
+        if (f->menu == self || f->menu == self->more_menu) {
+            menu_frame_hide_submenu(f);
+            break;
+        }
+    }
+
+    dead = g_slist_prepend(NULL, self);
+    g_hash_table_foreach(menu_hash, find_created_by, &dead);
+    dead = g_slist_delete_link(dead, dead); /* remove self */
+    while (dead) {
+        menu_free(dead->data);
+        dead = g_slist_delete_link(dead, dead);
+    }
+
+    clear_entries(self);
+}
+
+static void pipe_finish(ObMenuPipe *p, gboolean ok)
+{
+    ObMenu *self = p->menu;
+    GList *it;
+
+    if (ok) {
+        if (obt_xml_load_push(menu_parse_inst, p->parser,
+                              "openbox_pipe_menu"))
+        {
+            /* replace the cached entries if we were refreshing them */
+            if (!p->loading)
+                pipe_drop_contents(self);
+
+            menu_parse_state.pipe_creator = self;
+            menu_parse_state.parent = self;
+            obt_xml_tree_from_root(menu_parse_inst);
+            obt_xml_close(menu_parse_inst);
+            menu_parse_state.pipe_creator = NULL;
+            menu_parse_state.parent = NULL;
+
+            self->pipe_time = g_get_monotonic_time();
+        } else {
+            g_message(_("Invalid output from pipe-menu \"%s\""),
+                      self->execute);
+        }
+    }
 
-    if (!g_spawn_command_line_sync(self->execute, &output, NULL, NULL, &err)) {
+    pipe_detach(p, !ok);
+
+    /* show the new entries in any open frames for the menu, including the
+       frames showing the entries that did not fit in it */
+    for (it = menu_frame_visible; it; it = g_list_next(it)) {
+        ObMenuFrame *f = it->data;
+        if (f->menu == self || f->menu == self->more_menu)
+            menu_frame_refresh(f);
+    }
+}
+
+static gboolean pipe_read(GIOChannel *source,
+                          G_GNUC_UNUSED GIOCondition cond,
+                          gpointer data)
+{
+    ObMenuPipe *p = data;
+    gchar buf[4096];
+    gsize len;
+    GIOStatus status;
+
+    /* parse as much as is available now */
+    do {
+        status = g_io_channel_read_chars(source, buf, sizeof(buf), &len,
+                                         NULL);
+        if (len > 0 && !obt_xml_push_data(p->parser, buf, len))
+            status = G_IO_STATUS_ERROR;
+    } while (status == G_IO_STATUS_NORMAL);
+
+    if (status == G_IO_STATUS_AGAIN)
+        return TRUE; /* wait for more */
+
+    if (status == G_IO_STATUS_ERROR)
+        g_message(_("Invalid output from pipe-menu \"%s\""),
+                  p->menu->execute);
+
+    p->read_id = 0; /* we are removing the source by returning FALSE */
+    pipe_finish(p, status == G_IO_STATUS_EOF);
+    return FALSE;
+}
+
+static gboolean pipe_timeout(gpointer data)
+{
+    ObMenuPipe *p = data;
+
+    g_message(_("Timed out waiting for pipe-menu \"%s\""), p->menu->execute);
+
+    p->timeout_id = 0; /* we are removing the source by returning FALSE */
+    pipe_finish(p, FALSE);
+    return FALSE; /* no repeat */
+}
+
+/*! Run in the pipe menu's command before it starts, so it leads its own
+  process group */
+static void pipe_child_setup(G_GNUC_UNUSED gpointer data)
+{
+    setpgid(0, 0);
+}
+
+/*! Start the pipe menu's command running.
+  @param placeholder If TRUE the menu has no entries, so show a placeholder
+                     entry until the command finishes.  Otherwise the current
+                     entries are replaced when it finishes.
+*/
+static void pipe_spawn(ObMenu *self, gboolean placeholder)
+{
+    gchar **argv = NULL;
+    GError *err = NULL;
+    GPid pid;
+    gint out;
+    ObMenuPipe *p;
+
+    /* the child is reaped by openbox's SIGCHLD handler, like the ones the
+       Execute action starts, so don't watch it with glib too */
+    if (!g_shell_parse_argv(self->execute, NULL, &argv, &err) ||
+        !g_spawn_async_with_pipes(NULL, argv, NULL,
+                                  G_SPAWN_SEARCH_PATH |
+                                  G_SPAWN_DO_NOT_REAP_CHILD,
+                                  pipe_child_setup, NULL, &pid, NULL, &out,
+                                  NULL, &err))
+    {
         g_message(_("Failed to execute command for pipe-menu \"%s\": %s"),
                   self->execute, err->message);
         g_error_free(err);
+        g_strfreev(argv);
         return;
     }
+    g_strfreev(argv);
+    /* also set the group here, so it exists even if the command has not
+       gotten to run yet when it is stopped */
+    setpgid(pid, pid);
+
+    p = g_slice_new(ObMenuPipe);
+    p->menu = self;
+    p->pid = pid;
+    p->parser = obt_xml_push_new();
+
+    p->channel = g_io_channel_unix_new(out);
+    g_io_channel_set_close_on_unref(p->channel, TRUE);
+    g_io_channel_set_encoding(p->channel, NULL, NULL);
+    g_io_channel_set_buffered(p->channel, FALSE);
+    g_io_channel_set_flags(p->channel, G_IO_FLAG_NONBLOCK, NULL);
+    p->read_id = g_io_add_watch(p->channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                pipe_read, p);
+    p->timeout_id = g_timeout_add_full(G_PRIORITY_DEFAULT, PIPE_MENU_TIMEOUT,
+                                       pipe_timeout, p, NULL);
+
+    if (placeholder) {
+        /* show something in the menu until the output arrives */
+        p->loading = menu_add_normal(self, -1, _("Loading..."), NULL, FALSE);
+        p->loading->data.normal.enabled = FALSE;
+    } else
+        p->loading = NULL;
+
+    self->pipe = p;
+}
 
-    if (obt_xml_load_mem(menu_parse_inst, output, strlen(output),
-                         "openbox_pipe_menu"))
-    {
-        menu_parse_state.pipe_creator = self;
-        menu_parse_state.parent = self;
-        obt_xml_tree_from_root(menu_parse_inst);
-        obt_xml_close(menu_parse_inst);
-    } else {
-        g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
+void menu_pipe_execute(ObMenu *self)
+{
+    if (!self->execute)
+        return;
+    if (self->pipe) /* the command is already running */
+        return;
+
+    if (self->entries) {
+        /* the entries are already created and cached, refresh them behind
+           the scenes if they have gotten old */
+        if (self->pipe_refresh_background && pipe_cache_stale(self))
+            pipe_spawn(self, FALSE);
     }
+    else
+        pipe_spawn(self, TRUE);
+}
 
-    g_free(output);
+void menu_pipe_cancel(ObMenu *self)
+{
+    /* let a refresh of cached entries finish even if the menu is closed, so
+       they are up to date the next time */
+    if (self->pipe && self->pipe->loading)
+        pipe_detach(self->pipe, TRUE);
 }
 
 static ObMenu* menu_from_name(gchar *name)
@@ -349,7 +704,15 @@ static void parse_menu(xmlNodePtr node, gpointer data)
         if ((menu = menu_new(name, title, TRUE, NULL))) {
             menu->pipe_creator = state->pipe_creator;
             if (obt_xml_attr_string(node, "execute", &script)) {
+                gint ttl;
+
                 menu->execute = obt_paths_expand_tilde(script);
+
+                /* how long to keep the command's output for */
+                if (obt_xml_attr_int(node, "ttl", &ttl))
+                    menu->pipe_ttl = MAX(ttl, 0);
+                if (obt_xml_attr_contains(node, "refresh", "background"))
+                    menu->pipe_refresh_background = TRUE;
             } else {
                 ObMenu *old;
 
@@ -434,6 +797,8 @@ static void menu_destroy_hash_value(ObMenu *self)
     if (self->destroy_func)
         self->destroy_func(self, self->data);
 
+    if (self->pipe)
+        pipe_detach(self->pipe, TRUE);
     menu_clear_entries(self);
     g_free(self->name);
     g_free(self->title);
@@ -582,6 +947,15 @@ void menu_entry_unref(ObMenuEntry *self)
     }
 }
 
+static void clear_entries(ObMenu *self)
+{
+    while (self->entries) {
+        menu_entry_unref(self->entries->data);
+        self->entries = g_list_delete_link(self->entries, self->entries);
+    }
+    self->more_menu->entries = self->entries; /* keep it in sync */
+}
+
 void menu_clear_entries(ObMenu *self)
 {
 #ifdef DEBUG
@@ -597,16 +971,14 @@ void menu_clear_entries(ObMenu *self)
     }
 #endif
 
-    while (self->entries) {
-        menu_entry_unref(self->entries->data);
-        self->entries = g_list_delete_link(self->entries, self->entries);
-    }
-    self->more_menu->entries = self->entries; /* keep it in sync */
+    clear_entries(self);
 }
 
 void menu_entry_remove(ObMenuEntry *self)
 {
     self->menu->entries = g_list_remove(self->menu->entries, self);
+    if (self->menu->more_menu) /* keep it in sync */
+        self->menu->more_menu->entries = self->menu->entries;
     menu_entry_unref(self);
 }
 
@@ -28,6 +28,7 @@
 struct _ObClient;
 struct _ObMenuFrame;
 struct _ObMenuEntryFrame;
+struct _ObMenuPipe;
 
 typedef struct _ObMenu ObMenu;
 typedef struct _ObMenuEntry ObMenuEntry;
@@ -74,6 +75,16 @@ struct _ObMenu
 
     /* Command to execute to rebuild the menu */
     gchar *execute;
+    /* The running command which is rebuilding the menu, if any */
+    struct _ObMenuPipe *pipe;
+    /* Seconds for which the command's output is kept and reused each time
+       the menu is shown, 0 to run the command each time */
+    guint pipe_ttl;
+    /* Show the kept output right away even after it expires, and replace it
+       when the command finishes running again */
+    gboolean pipe_refresh_background;
+    /* When the menu's entries were last made from the command's output */
+    gint64 pipe_time;
 
     /* ObMenuEntry list */
     GList *entries;
@@ -174,10 +185,18 @@ ObMenu* menu_new(const gchar *name, const gchar *title,
                  gboolean allow_shortcut_selection, gpointer data);
 void menu_free(ObMenu *menu);
 
-/*! Repopulate a pipe-menu by running its command */
+/*! Repopulate a pipe-menu by running its command.  The command runs in the
+  background, and the menu shows a placeholder entry until its output has been
+  read, at which point any visible frames for the menu are refreshed. */
 void menu_pipe_execute(ObMenu *self);
-/*! Clear a pipe-menu's entries */
+/*! Stop waiting for a pipe-menu's command, if the menu is waiting for it to
+  show any entries */
+void menu_pipe_cancel(ObMenu *self);
+/*! Clear the pipe-menus' entries, except for those which are being kept
+  according to their ttl */
 void menu_clear_pipe_caches(void);
+/*! Take the icon away from all the menu entries that show it */
+void menu_drop_icon(RrImage *icon);
 
 void menu_show_all_shortcuts(ObMenu *self, gboolean show);
 
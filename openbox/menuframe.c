@@ -35,6 +35,10 @@
 
 #define ITEM_HEIGHT (ob_rr_theme->menu_font_height + 2*PADDING)
 
+/* the most entry frames which are kept around to be reused after their menu
+   frame is hidden */
+#define MAX_POOLED_ENTRY_FRAMES 64
+
 #define FRAME_EVENTMASK (ButtonPressMask |ButtonMotionMask | EnterWindowMask |\
                          LeaveWindowMask)
 #define ENTRY_EVENTMASK (EnterWindowMask | LeaveWindowMask | \
@@ -45,12 +49,16 @@ GList *menu_frame_visible;
 GHashTable *menu_frame_map;
 
 static RrAppearance *a_sep;
+static GSList *entry_frame_pool = NULL;
+static guint entry_frame_pool_size = 0;
 static guint submenu_show_timer = 0;
 static guint submenu_hide_timer = 0;
 
 static ObMenuEntryFrame* menu_entry_frame_new(ObMenuEntry *entry,
                                               ObMenuFrame *frame);
 static void menu_entry_frame_free(ObMenuEntryFrame *self);
+static void menu_entry_frame_render(ObMenuEntryFrame *self);
+static void menu_entry_frame_pool_clear(void);
 static void menu_frame_update(ObMenuFrame *self);
 static gboolean submenu_show_timeout(gpointer data);
 static void menu_frame_hide(ObMenuFrame *self);
@@ -78,6 +86,45 @@ static void client_dest(G_GNUC_UNUSED ObClient *client)
     }
 }
 
+/*! Draws the menu entries again when their icons finish loading.  If an icon
+  could not be loaded, the entries lose it and the menus showing them are laid
+  out again without room for it. */
+static void icon_loaded(RrImage *image, gboolean loaded,
+                        G_GNUC_UNUSED gpointer data)
+{
+    GList *it, *eit;
+    GSList *refresh = NULL;
+
+    for (it = menu_frame_visible; it; it = g_list_next(it)) {
+        ObMenuFrame *f = it->data;
+
+        for (eit = f->entries; eit; eit = g_list_next(eit)) {
+            ObMenuEntryFrame *e = eit->data;
+
+            if (((e->entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
+                 (e->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) &&
+                e->entry->data.normal.icon == image)
+            {
+                if (loaded)
+                    menu_entry_frame_render(e);
+                else if (!g_slist_find(refresh, f))
+                    refresh = g_slist_prepend(refresh, f);
+            }
+        }
+    }
+
+    if (loaded) return;
+
+    menu_drop_icon(image);
+
+    /* refreshing a frame hides the frames opened from it, so start with the
+       first frame shown */
+    for (it = g_list_last(menu_frame_visible); it; it = g_list_previous(it))
+        if (g_slist_find(refresh, it->data))
+            menu_frame_refresh(it->data);
+    g_slist_free(refresh);
+}
+
 void menu_frame_startup(gboolean reconfig)
 {
     gint i;
@@ -94,14 +141,19 @@ void menu_frame_startup(gboolean reconfig)
 
     client_add_destroy_notify(client_dest);
     menu_frame_map = g_hash_table_new(g_int_hash, g_int_equal);
+
+    /* menus can show hundreds of icons, so don't wait for them to load */
+    RrImageCacheSetLoadedFunc(ob_rr_icons, icon_loaded, NULL);
 }
 
 void menu_frame_shutdown(gboolean reconfig)
 {
     RrAppearanceFree(a_sep);
+    menu_entry_frame_pool_clear();
 
     if (reconfig) return;
 
+    RrImageCacheSetLoadedFunc(ob_rr_icons, NULL, NULL);
     client_remove_destroy_notify(client_dest);
     g_hash_table_destroy(menu_frame_map);
 }
@@ -169,31 +221,45 @@ static ObMenuEntryFrame* menu_entry_frame_new(ObMenuEntry *entry,
                                               ObMenuFrame *frame)
 {
     ObMenuEntryFrame *self;
-    XSetWindowAttributes attr;
 
-    self = g_slice_new0(ObMenuEntryFrame);
+    if (entry_frame_pool) {
+        /* reuse the windows from an entry frame that was released */
+        self = entry_frame_pool->data;
+        entry_frame_pool = g_slist_delete_link(entry_frame_pool,
+                                               entry_frame_pool);
+        --entry_frame_pool_size;
+
+        XReparentWindow(obt_display, self->window, frame->window, 0, 0);
+    } else {
+        XSetWindowAttributes attr;
+
+        self = g_slice_new0(ObMenuEntryFrame);
+
+        /* every entry frame gets all of its windows, so that it can be
+           reused for an entry of any type */
+        attr.event_mask = ENTRY_EVENTMASK;
+        self->window = createWindow(frame->window, CWEventMask, &attr);
+        self->text = createWindow(self->window, 0, NULL);
+        self->icon = createWindow(self->window, 0, NULL);
+        self->bullet = createWindow(self->window, 0, NULL);
+
+        XMapWindow(obt_display, self->text);
+    }
+
     self->entry = entry;
     self->frame = frame;
+    self->ignore_enters = 0;
+    self->border = 0;
+    RECT_SET(self->area, 0, 0, 0, 0);
 
     menu_entry_ref(entry);
 
-    attr.event_mask = ENTRY_EVENTMASK;
-    self->window = createWindow(self->frame->window, CWEventMask, &attr);
-    self->text = createWindow(self->window, 0, NULL);
     g_hash_table_insert(menu_frame_map, &self->window, self);
     g_hash_table_insert(menu_frame_map, &self->text, self);
-    if ((entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
-        (entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
-        self->icon = createWindow(self->window, 0, NULL);
-        g_hash_table_insert(menu_frame_map, &self->icon, self);
-    }
-    if (entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
-        self->bullet = createWindow(self->window, 0, NULL);
-        g_hash_table_insert(menu_frame_map, &self->bullet, self);
-    }
+    g_hash_table_insert(menu_frame_map, &self->icon, self);
+    g_hash_table_insert(menu_frame_map, &self->bullet, self);
 
     XMapWindow(obt_display, self->window);
-    XMapWindow(obt_display, self->text);
 
     window_add(&self->window, MENUFRAME_AS_WINDOW(self->frame));
 
@@ -205,23 +271,55 @@ static void menu_entry_frame_free(ObMenuEntryFrame *self)
     if (self) {
         window_remove(self->window);
 
-        XDestroyWindow(obt_display, self->text);
-        XDestroyWindow(obt_display, self->window);
         g_hash_table_remove(menu_frame_map, &self->text);
         g_hash_table_remove(menu_frame_map, &self->window);
-        if ((self->entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
-            (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
-            XDestroyWindow(obt_display, self->icon);
-            g_hash_table_remove(menu_frame_map, &self->icon);
-        }
-        if (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
-            XDestroyWindow(obt_display, self->bullet);
-            g_hash_table_remove(menu_frame_map, &self->bullet);
+        g_hash_table_remove(menu_frame_map, &self->icon);
+        g_hash_table_remove(menu_frame_map, &self->bullet);
+
+        menu_entry_unref(self->entry);
+        self->entry = NULL;
+        self->frame = NULL;
+
+        if (entry_frame_pool_size < MAX_POOLED_ENTRY_FRAMES) {
+            /* keep the windows around for the next menu that is shown,
+               out of the way of the menu frame being destroyed */
+            XUnmapWindow(obt_display, self->window);
+            XReparentWindow(obt_display, self->window,
+                            obt_root(ob_screen), 0, 0);
+            entry_frame_pool = g_slist_prepend(entry_frame_pool, self);
+            ++entry_frame_pool_size;
+        } else {
+            /* this destroys the text, icon and bullet windows too */
+            XDestroyWindow(obt_display, self->window);
+            g_slice_free(ObMenuEntryFrame, self);
         }
+    }
+}
 
+/*! Point an existing entry frame at a different menu entry */
+static void menu_entry_frame_set_entry(ObMenuEntryFrame *self,
+                                       ObMenuEntry *entry)
+{
+    if (self->entry != entry) {
+        menu_entry_ref(entry);
         menu_entry_unref(self->entry);
+        self->entry = entry;
+    }
+    self->border = 0;
+}
+
+static void menu_entry_frame_pool_clear(void)
+{
+    while (entry_frame_pool) {
+        ObMenuEntryFrame *self = entry_frame_pool->data;
+
+        XDestroyWindow(obt_display, self->window);
         g_slice_free(ObMenuEntryFrame, self);
+
+        entry_frame_pool = g_slist_delete_link(entry_frame_pool,
+                                               entry_frame_pool);
     }
+    entry_frame_pool_size = 0;
 }
 
 void menu_frame_move(ObMenuFrame *self, gint x, gint y)
@@ -629,18 +727,20 @@ static void menu_entry_frame_render(ObMenuEntryFrame *self)
 }
 
 /*! this code is taken from the menu_frame_render. if that changes, this won't
-  work.. */
-static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
-                                        gboolean first_entry,
-                                        gboolean last_entry)
+  work..
+  This measures a menu entry without needing an entry frame for it, so that
+  the entries which don't fit on the screen never get frames created. */
+static gint menu_entry_get_height(ObMenuEntry *entry,
+                                  gboolean first_entry,
+                                  gboolean last_entry)
 {
     ObMenuEntryType t;
     gint h = 0;
 
     h += 2*PADDING;
 
-    if (self)
-        t = self->entry->type;
+    if (entry)
+        t = entry->type;
     else
         /* this is the More... entry, it's NORMAL type */
         t = OB_MENU_ENTRY_TYPE_NORMAL;
@@ -651,7 +751,7 @@ static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
         h += ob_rr_theme->menu_font_height;
         break;
     case OB_MENU_ENTRY_TYPE_SEPARATOR:
-        if (self->entry->data.separator.label != NULL) {
+        if (entry->data.separator.label != NULL) {
             h += ob_rr_theme->menu_title_height +
                 (ob_rr_theme->mbwidth - PADDING) * 2;
 
@@ -850,106 +950,115 @@ void menu_frame_render(ObMenuFrame *self)
 
 static void menu_frame_update(ObMenuFrame *self)
 {
-    GList *mit, *fit;
+    GList *first, *mit, *fit, *last;
     const Rect *a;
     gint h;
+    guint i, n;
+    gboolean more;
 
-    menu_pipe_execute(self->menu);
     menu_find_submenus(self->menu);
 
     self->selected = NULL;
 
+    /* * make the menu fit on the screen */
+
+    a = screen_physical_area_monitor(self->monitor);
+
     /* start at show_from */
-    mit = g_list_nth(self->menu->entries, self->show_from);
+    first = g_list_nth(self->menu->entries, self->show_from);
+
+    /* measure the menu's entries until they no longer fit, so that only the
+       entries which will be shown get frames (and windows) made for them,
+       no matter how long the menu is */
+    h = ob_rr_theme->mbwidth * 2; /* the border at the top and bottom */
+    n = 0;
+    last = NULL;
+    for (mit = first; mit; mit = g_list_next(mit)) {
+        gint eh = menu_entry_get_height(mit->data, n == 0,
+                                        g_list_next(mit) == NULL);
+
+        /* leave at least 1 entry though */
+        if (h + eh > a->height && n > 0)
+            break;
+        h += eh;
+        ++n;
+        last = mit;
+    }
+    more = mit != NULL;
+
+    if (more) {
+        /* take the height of our More... entry into account */
+        h += menu_entry_get_height(NULL, FALSE, TRUE);
+
+        /* pull out the entries that don't fit with the More... entry,
+           leaving at least 1 though */
+        while (h > a->height && n > 1) {
+            h -= menu_entry_get_height(last->data, FALSE, FALSE);
+            last = g_list_previous(last);
+            --n;
+        }
+    }
 
     /* go through the menu's and frame's entries and connect the frame entries
        to the menu entries */
-    for (fit = self->entries; mit && fit;
-         mit = g_list_next(mit), fit = g_list_next(fit))
+    mit = first;
+    for (i = 0, fit = self->entries; i < n && fit;
+         ++i, mit = g_list_next(mit), fit = g_list_next(fit))
     {
-        ObMenuEntryFrame *f = fit->data;
-        f->entry = mit->data;
+        menu_entry_frame_set_entry(fit->data, mit->data);
     }
 
-    /* if there are more menu entries than in the frame, add them */
-    while (mit) {
+    /* if there are more menu entries to show than in the frame, add them */
+    for (; i < n; ++i, mit = g_list_next(mit)) {
         ObMenuEntryFrame *e = menu_entry_frame_new(mit->data, self);
         self->entries = g_list_append(self->entries, e);
-        mit = g_list_next(mit);
     }
 
     /* if there are more frame entries than menu entries then get rid of
        them */
     while (fit) {
-        GList *n = g_list_next(fit);
+        GList *next = g_list_next(fit);
         menu_entry_frame_free(fit->data);
         self->entries = g_list_delete_link(self->entries, fit);
-        fit = n;
+        fit = next;
     }
 
-    /* * make the menu fit on the screen */
-
-    /* calculate the height of the menu */
-    h = 0;
-    for (fit = self->entries; fit; fit = g_list_next(fit))
-        h += menu_entry_frame_get_height(fit->data,
-                                         fit == self->entries,
-                                         g_list_next(fit) == NULL);
-    /* add the border at the top and bottom */
-    h += ob_rr_theme->mbwidth * 2;
-
-    a = screen_physical_area_monitor(self->monitor);
-
-    if (h > a->height) {
-        GList *flast, *tmp;
-        gboolean last_entry = TRUE;
-
-        /* take the height of our More... entry into account */
-        h += menu_entry_frame_get_height(NULL, FALSE, TRUE);
-
-        /* start at the end of the entries */
-        flast = g_list_last(self->entries);
+    if (more) {
+        ObMenuEntry *more_entry;
+        ObMenuEntryFrame *more_frame;
+        /* make the More... menu entry frame which will display in this
+           frame.
+           if self->menu->more_menu is NULL that means that this is already
+           More... menu, so just use ourself.
+        */
+        more_entry = menu_get_more((self->menu->more_menu ?
+                                    self->menu->more_menu :
+                                    self->menu),
+                                   /* continue where we left off */
+                                   self->show_from + n);
+        more_frame = menu_entry_frame_new(more_entry, self);
+        /* make it get deleted when the menu frame goes away */
+        menu_entry_unref(more_entry);
+
+        /* add our More... entry to the frame */
+        self->entries = g_list_append(self->entries, more_frame);
+    }
 
-        /* pull out all the entries from the frame that don't
-           fit on the screen, leaving at least 1 though */
-        while (h > a->height && g_list_previous(flast) != NULL) {
-            /* update the height, without this entry */
-            h -= menu_entry_frame_get_height(flast->data, FALSE, last_entry);
+    menu_frame_render(self);
+}
 
-            /* destroy the entry we're not displaying */
-            tmp = flast;
-            flast = g_list_previous(flast);
-            menu_entry_frame_free(tmp->data);
-            self->entries = g_list_delete_link(self->entries, tmp);
+void menu_frame_refresh(ObMenuFrame *self)
+{
+    gint dx, dy;
 
-            /* only the first one that we see is the last entry in the menu */
-            last_entry = FALSE;
-        };
+    /* the entry that a submenu was opened from may be gone */
+    menu_frame_hide_submenu(self);
 
-        {
-            ObMenuEntry *more_entry;
-            ObMenuEntryFrame *more_frame;
-            /* make the More... menu entry frame which will display in this
-               frame.
-               if self->menu->more_menu is NULL that means that this is already
-               More... menu, so just use ourself.
-            */
-            more_entry = menu_get_more((self->menu->more_menu ?
-                                        self->menu->more_menu :
-                                        self->menu),
-                                       /* continue where we left off */
-                                       self->show_from +
-                                       g_list_length(self->entries));
-            more_frame = menu_entry_frame_new(more_entry, self);
-            /* make it get deleted when the menu frame goes away */
-            menu_entry_unref(more_entry);
-
-            /* add our More... entry to the frame */
-            self->entries = g_list_append(self->entries, more_frame);
-        }
-    }
+    menu_frame_update(self);
 
-    menu_frame_render(self);
+    /* the size has changed, so keep it on the screen */
+    menu_frame_move_on_screen(self, self->area.x, self->area.y, &dx, &dy);
+    menu_frame_move(self, self->area.x + dx, self->area.y + dy);
 }
 
 static gboolean menu_frame_is_visible(ObMenuFrame *self)
@@ -986,6 +1095,7 @@ static gboolean menu_frame_show(ObMenuFrame *self)
         }
     }
 
+    menu_pipe_execute(self->menu);
     menu_frame_update(self);
 
     menu_frame_visible = g_list_prepend(menu_frame_visible, self);
@@ -1125,6 +1235,9 @@ static void menu_frame_hide(ObMenuFrame *self)
 
     menu_frame_free(self);
 
+    /* don't keep waiting for the contents of a closed pipe menu */
+    menu_pipe_cancel(menu);
+
     if (menu->cleanup_func)
         menu->cleanup_func(menu, menu->data);
 }
@@ -1140,6 +1253,12 @@ void menu_frame_hide_all(void)
         menu_frame_hide(it->data);
 }
 
+void menu_frame_hide_submenu(ObMenuFrame *self)
+{
+    if (self->child)
+        menu_frame_hide(self->child);
+}
+
 ObMenuFrame* menu_frame_under(gint x, gint y)
 {
     ObMenuFrame *ret = NULL;
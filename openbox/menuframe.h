@@ -127,9 +127,14 @@ gboolean menu_frame_show_submenu(ObMenuFrame *self, ObMenuFrame *parent,
                                  ObMenuEntryFrame *parent_entry);
 
 void menu_frame_hide_all(void);
+/*! Hide the submenu that is open from the menu frame, if there is one */
+void menu_frame_hide_submenu(ObMenuFrame *self);
 void menu_frame_hide_all_client(struct _ObClient *client);
 
 void menu_frame_render(ObMenuFrame *self);
+/*! Show the menu's current entries in the frame, after they have changed
+  while the frame was visible */
+void menu_frame_refresh(ObMenuFrame *self);
 
 void menu_frame_select(ObMenuFrame *self, ObMenuEntryFrame *entry,
                        gboolean immediate);
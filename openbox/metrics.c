@@ -0,0 +1,217 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   metrics.c for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "metrics.h"
+#include "openbox.h"
+#include "debug.h"
+#include "obrender/render.h"
+#include "obt/display.h"
+#include "obt/prop.h"
+#include "obt/xqueue.h"
+
+#include <string.h>
+
+/*! Latencies are counted in buckets of powers of two microseconds, the
+  first is below 2us and the last is everything from 32ms */
+#define NUM_BUCKETS 16
+
+/*! Core events are counted by type, and all extension events together in
+  one more */
+#define NUM_EVENT_TYPES (LASTEvent + 1)
+
+typedef struct _EventStats {
+    gulong count;
+    gint64 usec;
+    gint64 max_usec;
+    /*! The X requests made while handling the events */
+    gulong requests;
+    gulong buckets[NUM_BUCKETS];
+} EventStats;
+
+static const gchar *event_names[LASTEvent] = {
+    NULL, NULL, "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+    "MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+    "KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+    "VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+    "MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+    "ConfigureRequest", "GravityNotify", "ResizeRequest",
+    "CirculateNotify", "CirculateRequest", "PropertyNotify",
+    "SelectionClear", "SelectionRequest", "SelectionNotify",
+    "ColormapNotify", "ClientMessage", "MappingNotify"
+};
+
+static const gchar *surface_names[RR_SURFACE_NUM_TYPES] = {
+    "none", "parentrelative", "solid", "splitvertical", "horizontal",
+    "vertical", "diagonal", "crossdiagonal", "pyramid", "mirrorhorizontal"
+};
+
+static EventStats  events[NUM_EVENT_TYPES];
+/*! Maps a call site (a G_STRLOC string) to the round trips made there */
+static GHashTable *round_trips = NULL;
+static gulong      prop_reads_base;
+static gulong      paint_count_base[RR_SURFACE_NUM_TYPES];
+static gint64      paint_usec_base[RR_SURFACE_NUM_TYPES];
+
+/*! Events waiting in the local queue when each event was handled */
+static gulong      depth_sum;
+static gulong      depth_max;
+
+static gint64      event_start;
+static gulong      event_request;
+
+void metrics_startup(gboolean reconfig)
+{
+    if (reconfig) return;
+
+    round_trips = g_hash_table_new(g_str_hash, g_str_equal);
+    metrics_request(OB_METRICS_RESET);
+}
+
+void metrics_shutdown(gboolean reconfig)
+{
+    if (reconfig) return;
+
+    g_hash_table_destroy(round_trips);
+    round_trips = NULL;
+}
+
+void metrics_event_start(void)
+{
+    const gulong depth = xqueue_length_local();
+
+    depth_sum += depth;
+    depth_max = MAX(depth_max, depth);
+
+    event_request = XNextRequest(obt_display);
+    event_start = g_get_monotonic_time();
+}
+
+void metrics_event_end(gint type)
+{
+    EventStats *s;
+    gint64 usec;
+    gint b;
+
+    usec = g_get_monotonic_time() - event_start;
+
+    if (type < 0 || type >= LASTEvent)
+        type = NUM_EVENT_TYPES - 1;
+    s = &events[type];
+
+    ++s->count;
+    s->usec += usec;
+    s->max_usec = MAX(s->max_usec, usec);
+    s->requests += XNextRequest(obt_display) - event_request;
+
+    for (b = 0; b < NUM_BUCKETS - 1 && usec >= (2 << b); ++b);
+    ++s->buckets[b];
+}
+
+void metrics_count_round_trip(const gchar *site)
+{
+    gulong n;
+
+    n = GPOINTER_TO_UINT(g_hash_table_lookup(round_trips, site));
+    g_hash_table_insert(round_trips, (gchar*)site, GUINT_TO_POINTER(n + 1));
+}
+
+static gint site_cmp(gconstpointer a, gconstpointer b)
+{
+    return strcmp(a, b);
+}
+
+static void publish(void)
+{
+    GString *str;
+    GList *sites, *it;
+    gulong count[RR_SURFACE_NUM_TYPES], total;
+    gint64 usec[RR_SURFACE_NUM_TYPES];
+    gint i, b;
+
+    str = g_string_new(NULL);
+
+    g_string_append(str, "# event  count  avg_us  max_us  requests  "
+                    "buckets(<2us <4us ... >=32ms)\n");
+    total = 0;
+    for (i = 0; i < NUM_EVENT_TYPES; ++i) {
+        const EventStats *s = &events[i];
+
+        if (!s->count) continue;
+        total += s->count;
+
+        if (i == NUM_EVENT_TYPES - 1)
+            g_string_append(str, "event Extension");
+        else if (event_names[i])
+            g_string_append_printf(str, "event %s", event_names[i]);
+        else
+            g_string_append_printf(str, "event Event%d", i);
+        g_string_append_printf(str, " %lu %ld %ld %lu",
+                               s->count, (glong)(s->usec / s->count),
+                               (glong)s->max_usec, s->requests);
+        for (b = 0; b < NUM_BUCKETS; ++b)
+            g_string_append_printf(str, " %lu", s->buckets[b]);
+        g_string_append_c(str, '\n');
+    }
+
+    g_string_append(str, "# queue  avg_depth  max_depth\n");
+    g_string_append_printf(str, "queue %lu %lu\n",
+                           (total ? depth_sum / total : 0), depth_max);
+
+    g_string_append(str, "# roundtrip  site  count\n");
+    g_string_append_printf(str, "roundtrip obt/prop.c %lu\n",
+                           obt_prop_reads() - prop_reads_base);
+    sites = g_list_sort(g_hash_table_get_keys(round_trips), site_cmp);
+    for (it = sites; it; it = g_list_next(it))
+        g_string_append_printf(str, "roundtrip %s %u\n", (gchar*)it->data,
+                               GPOINTER_TO_UINT(
+                                   g_hash_table_lookup(round_trips,
+                                                       it->data)));
+    g_list_free(sites);
+
+    g_string_append(str, "# render  surface  count  avg_us\n");
+    RrPaintStats(count, usec);
+    for (i = 0; i < RR_SURFACE_NUM_TYPES; ++i) {
+        count[i] -= paint_count_base[i];
+        usec[i] -= paint_usec_base[i];
+        if (count[i])
+            g_string_append_printf(str, "render %s %lu %ld\n",
+                                   surface_names[i], count[i],
+                                   (glong)(usec[i] / count[i]));
+    }
+
+    OBT_PROP_SETS(obt_root(ob_screen), OB_METRICS, str->str);
+    g_string_free(str, TRUE);
+}
+
+void metrics_request(ObMetricsRequest r)
+{
+    switch (r) {
+    case OB_METRICS_PUBLISH:
+        publish();
+        break;
+    case OB_METRICS_RESET:
+        memset(events, 0, sizeof(events));
+        g_hash_table_remove_all(round_trips);
+        prop_reads_base = obt_prop_reads();
+        RrPaintStats(paint_count_base, paint_usec_base);
+        depth_sum = depth_max = 0;
+        break;
+    default:
+        ob_debug("Unknown _OB_METRICS request %d", r);
+    }
+}
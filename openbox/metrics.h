@@ -0,0 +1,47 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   metrics.h for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __metrics_h
+#define __metrics_h
+
+#include <X11/Xlib.h>
+#include <glib.h>
+
+/*! What a client can ask for in an _OB_METRICS message to the root window */
+typedef enum {
+    OB_METRICS_PUBLISH = 0, /*!< Write the report to the _OB_METRICS
+                              property on the root window */
+    OB_METRICS_RESET = 1    /*!< Start counting again from zero */
+} ObMetricsRequest;
+
+void metrics_startup(gboolean reconfig);
+void metrics_shutdown(gboolean reconfig);
+
+/*! Call when starting to handle an X event */
+void metrics_event_start(void);
+/*! Call when done handling an X event of the given type */
+void metrics_event_end(gint type);
+
+/*! Counts a round trip to the X server at the place it is used */
+#define metrics_round_trip() metrics_count_round_trip(G_STRLOC)
+void metrics_count_round_trip(const gchar *site);
+
+/*! Handles an _OB_METRICS message sent to the root window */
+void metrics_request(ObMetricsRequest r);
+
+#endif
@@ -30,6 +30,7 @@
 #include "config.h"
 #include "event.h"
 #include "debug.h"
+#include "metrics.h"
 #include "obrender/render.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
@@ -65,6 +66,9 @@ static gboolean edge_warp_odd = FALSE;
 static guint edge_warp_timer = 0;
 static ObDirection key_resize_edge = -1;
 static guint waiting_for_sync;
+static guint pace_timer = 0;
+static gboolean motion_pending = FALSE;
+static gint pending_x, pending_y;
 #ifdef SYNC
 static guint sync_timer = 0;
 #endif
@@ -75,6 +79,7 @@ static void do_move(gboolean keyboard, gint keydist);
 static void do_resize(void);
 static void do_edge_warp(gint x, gint y);
 static void cancel_edge_warp();
+static void flush_motion(void);
 #ifdef SYNC
 static gboolean sync_timeout_func(gpointer data);
 #endif
@@ -311,6 +316,16 @@ void moveresize_start(ObClient *c, gint x, gint y, guint b, guint32 cnr)
 
 void moveresize_end(gboolean cancel)
 {
+    /* drop any paced motion when cancelling, otherwise put the window where
+       the pointer last was before finishing */
+    if (cancel) {
+        if (pace_timer) g_source_remove(pace_timer);
+        pace_timer = 0;
+        motion_pending = FALSE;
+    }
+    else
+        flush_motion();
+
     ungrab_keyboard();
     ungrab_pointer();
 
@@ -603,6 +618,7 @@ static void edge_warp_move_ptr(void)
     }
 
     XWarpPointer(obt_display, 0, obt_root(ob_screen), 0, 0, 0, 0, x, y);
+    screen_forget_pointer_pos();
 }
 
 static gboolean edge_warp_delay_func(G_GNUC_UNUSED gpointer data)
@@ -719,7 +735,9 @@ static void move_with_keys(KeySym sym, guint state)
 
     screen_pointer_pos(&opx, &opy);
     XWarpPointer(obt_display, None, None, 0, 0, 0, 0, dx, dy);
+    screen_forget_pointer_pos();
     /* steal the motion events this causes */
+    metrics_round_trip();
     XSync(obt_display, FALSE);
     {
         XEvent ce;
@@ -911,7 +929,9 @@ static void resize_with_keys(KeySym sym, guint state)
 
     screen_pointer_pos(&opx, &opy);
     XWarpPointer(obt_display, None, None, 0, 0, 0, 0, pdx, pdy);
+    screen_forget_pointer_pos();
     /* steal the motion events this causes */
+    metrics_round_trip();
     XSync(obt_display, FALSE);
     {
         XEvent ce;
@@ -931,12 +951,160 @@ static void resize_with_keys(KeySym sym, guint state)
 
 }
 
+static void do_motion(gint px, gint py)
+{
+    if (moving) {
+        cur_x = start_cx + px - start_x;
+        cur_y = start_cy + py - start_y;
+        do_move(FALSE, 0);
+        do_edge_warp(px, py);
+    } else {
+        gint dw, dh;
+        ObDirection dir;
+
+        if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT)) {
+            dw = -(px - start_x);
+            dh = -(py - start_y);
+            dir = OB_DIRECTION_NORTHWEST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP)) {
+            dw = 0;
+            dh = -(py - start_y);
+            dir = OB_DIRECTION_NORTH;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT)) {
+            dw = (px - start_x);
+            dh = -(py - start_y);
+            dir = OB_DIRECTION_NORTHEAST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_RIGHT)) {
+            dw = (px - start_x);
+            dh = 0;
+            dir = OB_DIRECTION_EAST;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMRIGHT)) {
+            dw = (px - start_x);
+            dh = (py - start_y);
+            dir = OB_DIRECTION_SOUTHEAST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOM))
+        {
+            dw = 0;
+            dh = (py - start_y);
+            dir = OB_DIRECTION_SOUTH;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT)) {
+            dw = -(px - start_x);
+            dh = (py - start_y);
+            dir = OB_DIRECTION_SOUTHWEST;
+        } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT)) {
+            dw = -(px - start_x);
+            dh = 0;
+            dir = OB_DIRECTION_WEST;
+        } else if (corner ==
+                   OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_KEYBOARD)) {
+            dw = (px - start_x);
+            dh = (py - start_y);
+            dir = OB_DIRECTION_SOUTHEAST;
+        } else
+            g_assert_not_reached();
+
+        /* override the client's max state if desired */
+        if (ABS(dw) >= config_resist_edge) {
+            if (moveresize_client->max_horz) {
+                /* unmax horz */
+                was_max_horz = TRUE;
+                pre_max_area.x = moveresize_client->pre_max_area.x;
+                pre_max_area.width = moveresize_client->pre_max_area.width;
+
+                moveresize_client->pre_max_area.x = cur_x;
+                moveresize_client->pre_max_area.width = cur_w;
+                client_maximize(moveresize_client, FALSE, 1);
+            }
+        }
+        else if (was_max_horz && !moveresize_client->max_horz) {
+            /* remax horz and put the premax back */
+            client_maximize(moveresize_client, TRUE, 1);
+            moveresize_client->pre_max_area.x = pre_max_area.x;
+            moveresize_client->pre_max_area.width = pre_max_area.width;
+        }
+
+        if (ABS(dh) >= config_resist_edge) {
+            if (moveresize_client->max_vert) {
+                /* unmax vert */
+                was_max_vert = TRUE;
+                pre_max_area.y = moveresize_client->pre_max_area.y;
+                pre_max_area.height =
+                    moveresize_client->pre_max_area.height;
+
+                moveresize_client->pre_max_area.y = cur_y;
+                moveresize_client->pre_max_area.height = cur_h;
+                client_maximize(moveresize_client, FALSE, 2);
+            }
+        }
+        else if (was_max_vert && !moveresize_client->max_vert) {
+            /* remax vert and put the premax back */
+            client_maximize(moveresize_client, TRUE, 2);
+            moveresize_client->pre_max_area.y = pre_max_area.y;
+            moveresize_client->pre_max_area.height = pre_max_area.height;
+        }
+
+        dw -= cur_w - start_cw;
+        dh -= cur_h - start_ch;
+
+        calc_resize(FALSE, 0, &dw, &dh, dir);
+        cur_w += dw;
+        cur_h += dh;
+
+        if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT))
+        {
+            cur_x -= dw;
+        }
+        if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP) ||
+            corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT))
+        {
+            cur_y -= dh;
+        }
+
+        do_resize();
+    }
+}
+
+static gboolean pace_timeout_func(G_GNUC_UNUSED gpointer data)
+{
+    if (!motion_pending) {
+        /* the pointer stopped, so stop waking up until it moves again */
+        pace_timer = 0;
+        return FALSE; /* don't repeat */
+    }
+    motion_pending = FALSE;
+    do_motion(pending_x, pending_y);
+    return TRUE; /* keep pacing */
+}
+
+/*! Apply any pointer motion which is waiting for the pacing timer, so that
+  nothing else sees the window behind the pointer */
+static void flush_motion(void)
+{
+    if (pace_timer) {
+        g_source_remove(pace_timer);
+        pace_timer = 0;
+    }
+    if (motion_pending) {
+        motion_pending = FALSE;
+        do_motion(pending_x, pending_y);
+    }
+}
+
 gboolean moveresize_event(XEvent *e)
 {
     gboolean used = FALSE;
 
     if (!moveresize_in_progress) return FALSE;
 
+    if (e->type != MotionNotify)
+        flush_motion();
+
     if (e->type == ButtonPress) {
         if (!button) {
             start_x = e->xbutton.x_root;
@@ -950,121 +1118,21 @@ gboolean moveresize_event(XEvent *e)
             used = TRUE;
         }
     } else if (e->type == MotionNotify) {
-        if (moving) {
-            cur_x = start_cx + e->xmotion.x_root - start_x;
-            cur_y = start_cy + e->xmotion.y_root - start_y;
-            do_move(FALSE, 0);
-            do_edge_warp(e->xmotion.x_root, e->xmotion.y_root);
-        } else {
-            gint dw, dh;
-            ObDirection dir;
-
-            if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT)) {
-                dw = -(e->xmotion.x_root - start_x);
-                dh = -(e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_NORTHWEST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP)) {
-                dw = 0;
-                dh = -(e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_NORTH;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = -(e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_NORTHEAST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_RIGHT)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = 0;
-                dir = OB_DIRECTION_EAST;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMRIGHT)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTHEAST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOM))
-            {
-                dw = 0;
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTH;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT)) {
-                dw = -(e->xmotion.x_root - start_x);
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTHWEST;
-            } else if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT)) {
-                dw = -(e->xmotion.x_root - start_x);
-                dh = 0;
-                dir = OB_DIRECTION_WEST;
-            } else if (corner ==
-                       OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_KEYBOARD)) {
-                dw = (e->xmotion.x_root - start_x);
-                dh = (e->xmotion.y_root - start_y);
-                dir = OB_DIRECTION_SOUTHEAST;
-            } else
-                g_assert_not_reached();
-
-            /* override the client's max state if desired */
-            if (ABS(dw) >= config_resist_edge) {
-                if (moveresize_client->max_horz) {
-                    /* unmax horz */
-                    was_max_horz = TRUE;
-                    pre_max_area.x = moveresize_client->pre_max_area.x;
-                    pre_max_area.width = moveresize_client->pre_max_area.width;
-
-                    moveresize_client->pre_max_area.x = cur_x;
-                    moveresize_client->pre_max_area.width = cur_w;
-                    client_maximize(moveresize_client, FALSE, 1);
-                }
-            }
-            else if (was_max_horz && !moveresize_client->max_horz) {
-                /* remax horz and put the premax back */
-                client_maximize(moveresize_client, TRUE, 1);
-                moveresize_client->pre_max_area.x = pre_max_area.x;
-                moveresize_client->pre_max_area.width = pre_max_area.width;
-            }
-
-            if (ABS(dh) >= config_resist_edge) {
-                if (moveresize_client->max_vert) {
-                    /* unmax vert */
-                    was_max_vert = TRUE;
-                    pre_max_area.y = moveresize_client->pre_max_area.y;
-                    pre_max_area.height =
-                        moveresize_client->pre_max_area.height;
-
-                    moveresize_client->pre_max_area.y = cur_y;
-                    moveresize_client->pre_max_area.height = cur_h;
-                    client_maximize(moveresize_client, FALSE, 2);
-                }
-            }
-            else if (was_max_vert && !moveresize_client->max_vert) {
-                /* remax vert and put the premax back */
-                client_maximize(moveresize_client, TRUE, 2);
-                moveresize_client->pre_max_area.y = pre_max_area.y;
-                moveresize_client->pre_max_area.height = pre_max_area.height;
+        if (config_resize_rate > 0) {
+            /* apply the first motion right away, and then at most one per
+               interval with wherever the pointer was last seen */
+            pending_x = e->xmotion.x_root;
+            pending_y = e->xmotion.y_root;
+            if (pace_timer)
+                motion_pending = TRUE;
+            else {
+                do_motion(pending_x, pending_y);
+                pace_timer = g_timeout_add(MAX(1000 / config_resize_rate, 1),
+                                           pace_timeout_func, NULL);
             }
-
-            dw -= cur_w - start_cw;
-            dh -= cur_h - start_ch;
-
-            calc_resize(FALSE, 0, &dw, &dh, dir);
-            cur_w += dw;
-            cur_h += dh;
-
-            if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_LEFT) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_BOTTOMLEFT))
-            {
-                cur_x -= dw;
-            }
-            if (corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPLEFT) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOP) ||
-                corner == OBT_PROP_ATOM(NET_WM_MOVERESIZE_SIZE_TOPRIGHT))
-            {
-                cur_y -= dh;
-            }
-
-            do_resize();
         }
+        else
+            do_motion(e->xmotion.x_root, e->xmotion.y_root);
         used = TRUE;
     } else if (e->type == KeyPress) {
         KeySym sym = obt_keyboard_keypress_to_keysym(e);
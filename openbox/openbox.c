@@ -40,12 +40,16 @@
 #include "config.h"
 #include "ping.h"
 #include "prompt.h"
+#include "metrics.h"
+#include "restart_state.h"
 #include "gettext.h"
 #include "obrender/render.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
+#include "obt/paths.h"
 #include "obt/signal.h"
+#include "obt/trace.h"
 #include "obt/prop.h"
 #include "obt/keyboard.h"
 #include "obt/xml.h"
@@ -104,8 +108,13 @@ static guint     remote_control = 0;
 static gboolean  being_replaced = FALSE;
 static gchar    *config_file = NULL;
 static gchar    *startup_cmd = NULL;
+static gboolean  trace = FALSE;
+
+/*! How many span boundaries --trace keeps */
+#define TRACE_SIZE 65536
 
 static void signal_handler(gint signal);
+static void dump_trace(void);
 static void remove_args(gint *argc, gchar **argv, gint index, gint num);
 static void parse_env();
 static void parse_args(gint *argc, gchar **argv);
@@ -172,6 +181,8 @@ gint main(gint argc, gchar **argv)
     obt_signal_add_callback(SIGCHLD, signal_handler);
     obt_signal_add_callback(SIGTTIN, signal_handler);
     obt_signal_add_callback(SIGTTOU, signal_handler);
+    if (trace)
+        obt_signal_add_callback(SIGPROF, signal_handler);
 
     ob_screen = DefaultScreen(obt_display);
 
@@ -229,22 +240,40 @@ gint main(gint argc, gchar **argv)
 
             {
                 ObtXmlInst *i;
+                gboolean loaded;
 
                 /* startup the parsing so everything can register sections
                    of the rc */
                 i = obt_xml_instance_new();
+                obt_xml_instance_set_cache(i, TRUE);
 
                 /* register all the available actions */
                 actions_startup(reconfigure);
+
+                /* load user options */
+                loaded = ((config_file &&
+                           obt_xml_load_file(i, config_file,
+                                             "openbox_config")) ||
+                          obt_xml_load_config_file(i, "openbox", "rc.xml",
+                                                   "openbox_config"));
+
+                /* find what changed since the last time, so only those
+                   things are set up again */
+                config_compare(loaded ? obt_xml_root(i) : NULL);
+                if (reconfigure) {
+                    if (RrThemeChanged(ob_rr_theme))
+                        config_changed |= OB_CONFIG_SECTION_THEME;
+                    /* release the old mouse bindings before they are
+                       replaced */
+                    if (config_changed & OB_CONFIG_SECTION_MOUSE)
+                        mouse_shutdown();
+                }
+
                 /* start up config which sets up with the parser */
                 config_startup(i);
 
-                /* parse/load user options */
-                if ((config_file &&
-                     obt_xml_load_file(i, config_file, "openbox_config")) ||
-                    obt_xml_load_config_file(i, "openbox", "rc.xml",
-                                             "openbox_config"))
-                {
+                /* parse user options */
+                if (loaded) {
                     obt_xml_tree_from_root(i);
                     obt_xml_close(i);
                 }
@@ -276,7 +305,7 @@ gint main(gint argc, gchar **argv)
             }
 
             /* load the theme specified in the rc file */
-            {
+            if (config_changed & OB_CONFIG_SECTION_THEME) {
                 RrTheme *theme;
                 if ((theme = RrThemeNew(ob_rr_inst, config_theme, TRUE,
                                         config_font_activewindow,
@@ -294,17 +323,18 @@ gint main(gint argc, gchar **argv)
 
                 OBT_PROP_SETS(obt_root(ob_screen), OB_THEME,
                               ob_rr_theme->name);
-            }
 
-            if (reconfigure) {
-                GList *it;
+                if (reconfigure) {
+                    GList *it;
 
-                /* update all existing windows for the new theme */
-                for (it = client_list; it; it = g_list_next(it)) {
-                    ObClient *c = it->data;
-                    frame_adjust_theme(c->frame);
+                    /* update all existing windows for the new theme */
+                    for (it = client_list; it; it = g_list_next(it)) {
+                        ObClient *c = it->data;
+                        frame_adjust_theme(c->frame);
+                    }
                 }
             }
+            metrics_startup(reconfigure);
             event_startup(reconfigure);
             /* focus_backup is used for stacking, so this needs to come before
                anything that calls stacking_add */
@@ -319,8 +349,9 @@ gint main(gint argc, gchar **argv)
             client_startup(reconfigure);
             dock_startup(reconfigure);
             moveresize_startup(reconfigure);
-            keyboard_startup();
-            mouse_startup();
+            keyboard_startup(reconfigure);
+            if (!reconfigure || (config_changed & OB_CONFIG_SECTION_MOUSE))
+                mouse_startup();
             menu_frame_startup(reconfigure);
             menu_startup(reconfigure);
             prompt_startup(reconfigure);
@@ -333,8 +364,11 @@ gint main(gint argc, gchar **argv)
                 guint32 xid;
                 ObWindow *w;
 
-                /* get all the existing windows */
+                /* get all the existing windows, with anything the openbox
+                   before a restart left for us */
+                restart_state_load();
                 window_manage_all();
+                restart_state_clear();
 
                 /* focus what was focused if a wm was already running */
                 if (OBT_PROP_GET32(obt_root(ob_screen),
@@ -343,7 +377,9 @@ gint main(gint argc, gchar **argv)
                 {
                     client_focus(WINDOW_AS_CLIENT(w));
                 }
-            } else {
+            } else if (config_changed & (OB_CONFIG_SECTION_THEME |
+                                         OB_CONFIG_SECTION_OTHER))
+            {
                 GList *it;
 
                 /* redecorate all existing windows */
@@ -384,14 +420,22 @@ gint main(gint argc, gchar **argv)
                 xmlprompt = NULL;
             }
 
-            if (!reconfigure)
+            if (!reconfigure) {
+                /* leave the window icons for the openbox we are about to
+                   exec into */
+                if (restart && !restart_path)
+                    restart_state_save();
                 window_unmanage_all();
+            }
 
             prompt_shutdown(reconfigure);
             menu_shutdown(reconfigure);
             menu_frame_shutdown(reconfigure);
-            mouse_shutdown();
-            keyboard_shutdown();
+            /* the mouse bindings are kept through a reconfigure, and only
+               released if they are going to be replaced */
+            if (!reconfigure)
+                mouse_shutdown();
+            keyboard_shutdown(reconfigure);
             moveresize_shutdown(reconfigure);
             dock_shutdown(reconfigure);
             client_shutdown(reconfigure);
@@ -404,7 +448,8 @@ gint main(gint argc, gchar **argv)
             focus_shutdown(reconfigure);
             window_shutdown(reconfigure);
             event_shutdown(reconfigure);
-            config_shutdown();
+            metrics_shutdown(reconfigure);
+            config_shutdown(reconfigure);
             actions_shutdown(reconfigure);
         } while (reconfigure);
     }
@@ -419,6 +464,8 @@ gint main(gint argc, gchar **argv)
 
     obt_display_close();
 
+    obt_trace_stop();
+
     if (restart) {
         ob_debug_shutdown();
         obt_signal_stop();
@@ -502,6 +549,9 @@ static void signal_handler(gint signal)
     case SIGTTOU:
         ob_debug("Caught signal %d. Ignoring.", signal);
         break;
+    case SIGPROF:
+        dump_trace();
+        break;
     default:
         ob_debug("Caught signal %d. Exiting.", signal);
         /* TERM and INT return a 0 code */
@@ -509,6 +559,29 @@ static void signal_handler(gint signal)
     }
 }
 
+static void dump_trace(void)
+{
+    ObtPaths *p;
+    gchar *name, *path;
+    GError *err = NULL;
+
+    name = g_strdup_printf("trace-%d-%" G_GINT64_FORMAT ".json",
+                           getpid(), g_get_real_time() / G_USEC_PER_SEC);
+    p = obt_paths_new();
+    path = g_build_filename(obt_paths_cache_home(p), "openbox", name, NULL);
+    obt_paths_unref(p);
+    g_free(name);
+
+    if (obt_trace_dump(path, &err))
+        g_message(_("Wrote the trace to \"%s\""), path);
+    else {
+        g_message(_("Unable to write the trace to \"%s\": %s"),
+                  path, err->message);
+        g_error_free(err);
+    }
+    g_free(path);
+}
+
 static void print_version(void)
 {
     g_print("Openbox %s\n", PACKAGE_VERSION);
@@ -544,6 +617,7 @@ static void print_help(void)
     g_print(_("  --debug-focus       Display debugging output for focus handling\n"));
     g_print(_("  --debug-session     Display debugging output for session management\n"));
     g_print(_("  --debug-xinerama    Split the display into fake xinerama screens\n"));
+    g_print(_("  --trace             Record timing traces, SIGPROF writes them to a file\n"));
     g_print(_("\nPlease report bugs at %s\n"), PACKAGE_BUGREPORT);
 }
 
@@ -650,6 +724,10 @@ static void parse_args(gint *argc, gchar **argv)
         else if (!strcmp(argv[i], "--debug-xinerama")) {
             ob_debug_xinerama = TRUE;
         }
+        else if (!strcmp(argv[i], "--trace")) {
+            trace = TRUE;
+            obt_trace_start(TRACE_SIZE);
+        }
         else if (!strcmp(argv[i], "--reconfigure")) {
             remote_control = 1;
         }
@@ -26,6 +26,7 @@
 #include "dock.h"
 #include "debug.h"
 #include "place_overlap.h"
+#include "obt/trace.h"
 
 static Rect *choose_pointer_monitor(ObClient *c)
 {
@@ -485,6 +486,8 @@ gboolean place_client(ObClient *client, gboolean client_to_be_foregrounded,
     if (!should_set_client_position(client, settings))
         return FALSE;
 
+    OBT_TRACE_BEGIN("place_client");
+
     x = &client_area->x;
     y = &client_area->y;
 
@@ -503,5 +506,7 @@ gboolean place_client(ObClient *client, gboolean client_to_be_foregrounded,
 
     /* get where the client should be */
     frame_frame_gravity(client->frame, x, y);
+
+    OBT_TRACE_END("place_client");
     return TRUE;
 }
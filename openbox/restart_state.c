@@ -0,0 +1,291 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   restart_state.c for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "restart_state.h"
+#include "client.h"
+#include "openbox.h"
+#include "debug.h"
+#include "gettext.h"
+#include "metrics.h"
+#include "obt/display.h"
+#include "obt/paths.h"
+#include "obt/prop.h"
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+
+/* The file is written and read by the same binary in the same process (a
+   restart execs over itself), so it is simply an array of guint32 in native
+   byte order.
+
+   header:  MAGIC VERSION pid root nentries
+   entry:   window iconlen prefix[KEY_PREFIX] pixmap mask npics
+            then npics times: width height pixels[width*height]
+*/
+
+#define MAGIC      0x4f425253 /* "OBRS" */
+#define VERSION    1
+#define HEADER_LEN 5
+
+/*! How many words at the start of _NET_WM_ICON are compared to see if the
+  icon changed */
+#define KEY_PREFIX 16
+
+/*! The icon hints of a window, compared before trusting a saved icon */
+typedef struct _IconKey {
+    guint32 iconlen;
+    guint32 prefix[KEY_PREFIX];
+    guint32 pixmap;
+    guint32 mask;
+} IconKey;
+
+#define ENTRY_LEN (2 + KEY_PREFIX + 3)
+
+static GMappedFile *state_file = NULL;
+/*! Maps a window to its entry in state_file */
+static GHashTable  *state_entries = NULL;
+
+static gchar* state_filename(void)
+{
+    ObtPaths *p;
+    gchar *name, *path;
+
+    name = g_strdup_printf("restart-%s-%d",
+                           DisplayString(obt_display), ob_screen);
+    g_strdelimit(name, "/", '_');
+
+    p = obt_paths_new();
+    path = g_build_filename(obt_paths_cache_home(p), "openbox", name, NULL);
+    obt_paths_unref(p);
+    g_free(name);
+    return path;
+}
+
+/*! Reads the hints that say which icon the window wants.  The partial read of
+  _NET_WM_ICON tells its full length without transferring the images. */
+static void get_icon_key(Window window, IconKey *key)
+{
+    Atom type;
+    gint format;
+    gulong n, after;
+    guchar *data;
+    XWMHints *hints;
+    guint i;
+
+    memset(key, 0, sizeof(IconKey));
+
+    metrics_round_trip();
+    if (XGetWindowProperty(obt_display, window, OBT_PROP_ATOM(NET_WM_ICON),
+                           0, KEY_PREFIX, False, XA_CARDINAL, &type, &format,
+                           &n, &after, &data) == Success)
+    {
+        if (type == XA_CARDINAL && format == 32) {
+            key->iconlen = n + after / 4;
+            for (i = 0; i < n && i < KEY_PREFIX; ++i)
+                key->prefix[i] = ((gulong*)data)[i];
+        }
+        if (data) XFree(data);
+    }
+
+    metrics_round_trip();
+    if ((hints = XGetWMHints(obt_display, window))) {
+        if (hints->flags & IconPixmapHint)
+            key->pixmap = hints->icon_pixmap;
+        if (hints->flags & IconMaskHint)
+            key->mask = hints->icon_mask;
+        XFree(hints);
+    }
+}
+
+static void put(GByteArray *buf, guint32 v)
+{
+    g_byte_array_append(buf, (guint8*)&v, sizeof(guint32));
+}
+
+void restart_state_save(void)
+{
+    GByteArray *buf;
+    GList *it;
+    guint32 count;
+    gchar *path;
+    GError *err = NULL;
+
+    buf = g_byte_array_new();
+    put(buf, MAGIC);
+    put(buf, VERSION);
+    put(buf, getpid());
+    put(buf, obt_root(ob_screen));
+    put(buf, 0); /* filled in below */
+
+    count = 0;
+    for (it = client_list; it; it = g_list_next(it)) {
+        ObClient *c = it->data;
+        RrImageSet *set;
+        IconKey key;
+        guint i;
+
+        if (!c->icon_set) continue;
+        set = c->icon_set->set;
+
+        get_icon_key(c->window, &key);
+
+        put(buf, c->window);
+        put(buf, key.iconlen);
+        for (i = 0; i < KEY_PREFIX; ++i)
+            put(buf, key.prefix[i]);
+        put(buf, key.pixmap);
+        put(buf, key.mask);
+        put(buf, set->n_original);
+        for (i = 0; i < (guint)set->n_original; ++i) {
+            RrImagePic *pic = set->original[i];
+
+            put(buf, pic->width);
+            put(buf, pic->height);
+            g_byte_array_append(buf, (guint8*)pic->data,
+                                pic->width * pic->height * sizeof(RrPixel32));
+        }
+        ++count;
+    }
+    ((guint32*)buf->data)[HEADER_LEN - 1] = count;
+
+    path = state_filename();
+    if (!g_file_set_contents(path, (gchar*)buf->data, buf->len, &err)) {
+        g_message(_("Unable to save the window state for restarting: %s"),
+                  err->message);
+        g_error_free(err);
+    }
+    else
+        ob_debug("Saved the icons of %u windows in %s", count, path);
+    g_free(path);
+    g_byte_array_free(buf, TRUE);
+}
+
+void restart_state_load(void)
+{
+    gchar *path;
+    const guint32 *data;
+    gsize len, pos;
+    guint32 count, i;
+
+    g_assert(state_file == NULL);
+
+    path = state_filename();
+    state_file = g_mapped_file_new(path, FALSE, NULL);
+    /* it is only good for this one restart */
+    unlink(path);
+    g_free(path);
+
+    if (!state_file) return;
+
+    data = (const guint32*)g_mapped_file_get_contents(state_file);
+    len = g_mapped_file_get_length(state_file) / sizeof(guint32);
+
+    /* only trust it if it was written by the openbox we replaced, for this
+       screen */
+    if (len < HEADER_LEN || data[0] != MAGIC || data[1] != VERSION ||
+        data[2] != (guint32)getpid() || data[3] != obt_root(ob_screen))
+    {
+        restart_state_clear();
+        return;
+    }
+    count = data[4];
+
+    state_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    pos = HEADER_LEN;
+    for (i = 0; i < count; ++i) {
+        const guint32 *e = data + pos;
+        guint32 npics, j;
+
+        if (pos + ENTRY_LEN > len) break;
+        npics = e[ENTRY_LEN - 1];
+        pos += ENTRY_LEN;
+
+        /* make sure all the pictures are inside the file */
+        for (j = 0; j < npics; ++j) {
+            if (pos + 2 > len) break;
+            if ((guint64)data[pos] * data[pos+1] > len - pos - 2) break;
+            pos += 2 + data[pos] * data[pos+1];
+        }
+        if (j < npics) break;
+
+        g_hash_table_insert(state_entries, GUINT_TO_POINTER(e[0]),
+                            (gpointer)e);
+    }
+
+    ob_debug("Loaded the icons of %u windows from before the restart",
+             g_hash_table_size(state_entries));
+}
+
+void restart_state_clear(void)
+{
+    if (state_entries) {
+        g_hash_table_destroy(state_entries);
+        state_entries = NULL;
+    }
+    if (state_file) {
+        g_mapped_file_free(state_file);
+        state_file = NULL;
+    }
+}
+
+RrImage* restart_state_icon(Window window)
+{
+    const guint32 *e;
+    IconKey key;
+    RrImage *img;
+    guint32 npics, i;
+
+    if (!state_entries) return NULL;
+
+    e = g_hash_table_lookup(state_entries, GUINT_TO_POINTER(window));
+    if (!e) return NULL;
+    g_hash_table_remove(state_entries, GUINT_TO_POINTER(window));
+
+    /* the window may have changed its icon while no one was watching */
+    get_icon_key(window, &key);
+    if (key.iconlen != e[1] ||
+        memcmp(key.prefix, e + 2, sizeof(key.prefix)) ||
+        key.pixmap != e[2 + KEY_PREFIX] ||
+        key.mask != e[3 + KEY_PREFIX])
+    {
+        return NULL;
+    }
+
+    img = NULL;
+    npics = e[ENTRY_LEN - 1];
+    e += ENTRY_LEN;
+    for (i = 0; i < npics; ++i) {
+        const guint32 w = e[0], h = e[1];
+
+        if (w > 0 && h > 0) {
+            if (!img)
+                img = RrImageNewFromData(ob_rr_icons, (RrPixel32*)e + 2,
+                                         w, h);
+            else
+                RrImageAddFromData(img, (RrPixel32*)e + 2, w, h);
+        }
+        e += 2 + w * h;
+    }
+    return img;
+}
@@ -0,0 +1,43 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   restart_state.h for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __restart_state_h
+#define __restart_state_h
+
+#include "obrender/render.h"
+
+#include <X11/Xlib.h>
+#include <glib.h>
+
+/*! Writes the icons of all the managed windows to a file, for the openbox
+  that is about to be exec'd by a restart to pick up again */
+void restart_state_save(void);
+
+/*! Loads the file written by restart_state_save, if this process is the one
+  it was written for, and removes it */
+void restart_state_load(void);
+
+/*! Forgets anything loaded by restart_state_load which was not used */
+void restart_state_clear(void);
+
+/*! Returns the icon saved for the window before the restart, if the window's
+  icon hints have not changed since, or NULL.  The returned image belongs to
+  the caller, and each window's icon is only given out once. */
+RrImage* restart_state_icon(Window window);
+
+#endif
@@ -35,6 +35,7 @@
 #include "version.h"
 #include "obrender/render.h"
 #include "gettext.h"
+#include "metrics.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
 #include "obt/prop.h"
@@ -83,6 +84,12 @@ static ObPagerPopup *desktop_popup;
 static guint         desktop_popup_timer = 0;
 static gboolean      desktop_popup_perm;
 
+/*! The pointer position reported by the event currently being handled, so
+  asking for it does not need a round trip to the server */
+static gboolean pointer_known = FALSE;
+static gint     pointer_x;
+static gint     pointer_y;
+
 /*! The number of microseconds that you need to be on a desktop before it will
   replace the remembered "last desktop" */
 #define REMEMBER_LAST_DESKTOP_TIME 750
@@ -308,6 +315,7 @@ gboolean screen_annex(void)
     supported[i++] = OBT_PROP_ATOM(OB_APP_GROUP_NAME);
     supported[i++] = OBT_PROP_ATOM(OB_APP_GROUP_CLASS);
     supported[i++] = OBT_PROP_ATOM(OB_APP_TYPE);
+    supported[i++] = OBT_PROP_ATOM(OB_METRICS);
     g_assert(i == num_support);
 
     OBT_PROP_SETA32(obt_root(ob_screen),
@@ -700,38 +708,40 @@ void screen_set_desktop(guint num, gboolean dofocus)
     if (moveresize_client)
         client_set_desktop(moveresize_client, num, TRUE, FALSE);
 
+    /* hold the server for the whole switch, so the maps and unmaps reach it
+       as one burst, instead of syncing with it for every window shown */
+    grab_server(TRUE);
+
     /* show windows before hiding the rest to lessen the enter/leave events */
 
-    /* show windows from top to bottom */
-    for (it = stacking_list; it; it = g_list_next(it)) {
-        if (WINDOW_IS_CLIENT(it->data)) {
-            ObClient *c = it->data;
-            client_show(c);
-        }
-    }
+    /* only the windows on the two desktops, and on all of them, can change
+       visibility */
+    for (it = focus_order_desktop_list(num); it; it = g_list_next(it))
+        client_show(it->data);
+    for (it = focus_order_desktop_list(DESKTOP_ALL); it; it = g_list_next(it))
+        client_show(it->data);
 
     if (dofocus) screen_fallback_focus();
 
-    /* hide windows from bottom to top */
-    for (it = g_list_last(stacking_list); it; it = g_list_previous(it)) {
-        if (WINDOW_IS_CLIENT(it->data)) {
-            ObClient *c = it->data;
-            if (client_hide(c)) {
-                if (c == focus_client) {
-                    /* c was focused and we didn't do fallback clearly so make
-                       sure openbox doesnt still consider the window focused.
-                       this happens when using NextWindow with allDesktops,
-                       since it doesnt want to move focus on desktop change,
-                       but the focus is not going to stay with the current
-                       window, which has now disappeared.
-                       only do this if the client was actually hidden,
-                       otherwise it can keep focus. */
-                    focus_set_client(NULL);
-                }
+    for (it = focus_order_desktop_list(previous); it; it = g_list_next(it)) {
+        ObClient *c = it->data;
+        if (client_hide(c)) {
+            if (c == focus_client) {
+                /* c was focused and we didn't do fallback clearly so make
+                   sure openbox doesnt still consider the window focused.
+                   this happens when using NextWindow with allDesktops,
+                   since it doesnt want to move focus on desktop change,
+                   but the focus is not going to stay with the current
+                   window, which has now disappeared.
+                   only do this if the client was actually hidden,
+                   otherwise it can keep focus. */
+                focus_set_client(NULL);
             }
         }
     }
 
+    grab_server(FALSE);
+
     focus_cycle_addremove(NULL, TRUE);
 
     event_end_ignore_all_enters(ignore_start);
@@ -1902,6 +1912,18 @@ guint screen_monitor_pointer()
     return screen_find_monitor_point(x, y);
 }
 
+void screen_set_pointer_pos(gint x, gint y)
+{
+    pointer_known = TRUE;
+    pointer_x = x;
+    pointer_y = y;
+}
+
+void screen_forget_pointer_pos(void)
+{
+    pointer_known = FALSE;
+}
+
 gboolean screen_pointer_pos(gint *x, gint *y)
 {
     Window w;
@@ -1909,6 +1931,14 @@ gboolean screen_pointer_pos(gint *x, gint *y)
     guint u;
     gboolean ret;
 
+    /* the event being handled already told us where the pointer is */
+    if (pointer_known) {
+        *x = pointer_x;
+        *y = pointer_y;
+        return TRUE;
+    }
+
+    metrics_round_trip();
     ret = !!XQueryPointer(obt_display, obt_root(ob_screen),
                           &w, &w, x, y, &i, &i, &u);
     if (!ret) {
@@ -171,6 +171,15 @@ void screen_set_root_cursor(void);
   is on this screen and FALSE if it is on another screen. */
 gboolean screen_pointer_pos(gint *x, gint *y);
 
+/*! Remembers where the pointer is, as reported by the event being handled.
+  Until screen_forget_pointer_pos() is called, screen_pointer_pos() gives this
+  back without asking the server. */
+void screen_set_pointer_pos(gint x, gint y);
+
+/*! Stops trusting the remembered pointer position, because the pointer may
+  have moved (it was warped, or the event that reported it is done). */
+void screen_forget_pointer_pos(void);
+
 /*! Returns the monitor which contains the pointer device */
 guint screen_monitor_pointer(void);
 
@@ -29,6 +29,7 @@
 #include "dock.h"
 #include "config.h"
 #include "obt/prop.h"
+#include "obt/trace.h"
 
 GList  *stacking_list = NULL;
 GList  *stacking_list_tail = NULL;
@@ -36,6 +37,12 @@ GList  *stacking_list_tail = NULL;
   to freeze the on-screen stacking order while a window is being temporarily
   raised during focus cycling */
 static gboolean pause_changes = FALSE;
+/*! When more than 0, stacking changes are only made to the stacking_list, and
+  are shown on the screen all at once by stacking_thaw */
+static guint freeze = 0;
+/*! The stacking_list changed while frozen */
+static gboolean frozen_restack = FALSE;
+static gboolean frozen_set_list = FALSE;
 
 void stacking_set_list(void)
 {
@@ -48,6 +55,13 @@ void stacking_set_list(void)
     */
     if (ob_state() == OB_STATE_EXITING) return;
 
+    if (freeze) {
+        frozen_set_list = TRUE;
+        return;
+    }
+
+    OBT_TRACE_BEGIN("stacking_set_list");
+
     /* create an array of the window ids (from bottom to top,
        reverse order!) */
     if (stacking_list) {
@@ -62,6 +76,8 @@ void stacking_set_list(void)
                     (gulong*)windows, i);
 
     g_free(windows);
+
+    OBT_TRACE_END("stacking_set_list");
 }
 
 static void do_restack(GList *wins, GList *before)
@@ -109,13 +125,49 @@ static void do_restack(GList *wins, GList *before)
     }
 #endif
 
-    if (!pause_changes)
+    if (freeze)
+        frozen_restack = TRUE;
+    else if (!pause_changes)
         XRestackWindows(obt_display, win, i);
     g_free(win);
 
     stacking_set_list();
 }
 
+void stacking_freeze(void)
+{
+    ++freeze;
+}
+
+void stacking_thaw(void)
+{
+    g_assert(freeze > 0);
+
+    if (--freeze) return;
+
+    OBT_TRACE_BEGIN("stacking_thaw");
+
+    if (frozen_restack && !pause_changes) {
+        Window *win;
+        GList *it;
+        gint i;
+
+        /* put every window in its place with a single request */
+        win = g_new(Window, g_list_length(stacking_list) + 1);
+        win[0] = screen_support_win;
+        for (i = 1, it = stacking_list; it; ++i, it = g_list_next(it))
+            win[i] = window_top(it->data);
+        XRestackWindows(obt_display, win, i);
+        g_free(win);
+    }
+    if (frozen_set_list)
+        stacking_set_list();
+
+    frozen_restack = frozen_set_list = FALSE;
+
+    OBT_TRACE_END("stacking_thaw");
+}
+
 void stacking_temp_raise(ObWindow *window)
 {
     Window win[2];
@@ -395,6 +447,8 @@ static void restack_windows(ObClient *selected, gboolean raise)
 
 void stacking_raise(ObWindow *window)
 {
+    OBT_TRACE_BEGIN("stacking_raise");
+
     if (WINDOW_IS_CLIENT(window)) {
         ObClient *selected;
         selected = WINDOW_AS_CLIENT(window);
@@ -407,10 +461,14 @@ void stacking_raise(ObWindow *window)
         g_list_free(wins);
     }
     stacking_list_tail = g_list_last(stacking_list);
+
+    OBT_TRACE_END("stacking_raise");
 }
 
 void stacking_lower(ObWindow *window)
 {
+    OBT_TRACE_BEGIN("stacking_lower");
+
     if (WINDOW_IS_CLIENT(window)) {
         ObClient *selected;
         selected = WINDOW_AS_CLIENT(window);
@@ -423,6 +481,8 @@ void stacking_lower(ObWindow *window)
         g_list_free(wins);
     }
     stacking_list_tail = g_list_last(stacking_list);
+
+    OBT_TRACE_END("stacking_lower");
 }
 
 void stacking_below(ObWindow *window, ObWindow *below)
@@ -432,12 +492,16 @@ void stacking_below(ObWindow *window, ObWindow *below)
     if (window_layer(window) != window_layer(below))
         return;
 
+    OBT_TRACE_BEGIN("stacking_below");
+
     wins = g_list_append(NULL, window);
     stacking_list = g_list_remove(stacking_list, window);
     before = g_list_next(g_list_find(stacking_list, below));
     do_restack(wins, before);
     g_list_free(wins);
     stacking_list_tail = g_list_last(stacking_list);
+
+    OBT_TRACE_END("stacking_below");
 }
 
 void stacking_add(ObWindow *win)
@@ -60,6 +60,15 @@ void stacking_temp_raise(struct _ObWindow *window);
 /*! Restores any temporarily raised windows to their correct place */
 void stacking_restore(void);
 
+/*! Stops stacking changes from being sent to the X server until
+  stacking_thaw is called the same number of times.  The stacking_list is
+  still kept up to date. */
+void stacking_freeze(void);
+
+/*! Restacks the windows on the screen, and publishes the stacking order, if
+  they changed since stacking_freeze was called */
+void stacking_thaw(void);
+
 /*! Lowers a window below all others in its stacking layer */
 void stacking_lower(struct _ObWindow *window);
 
@@ -26,9 +26,14 @@
 #include "prompt.h"
 #include "debug.h"
 #include "grab.h"
+#include "stacking.h"
+#include "metrics.h"
+#include "obt/display.h"
 #include "obt/prop.h"
 #include "obt/xqueue.h"
 
+#include <X11/Xatom.h>
+
 static GHashTable *window_map;
 
 static guint window_hash(Window *w) { return *w; }
@@ -108,42 +113,85 @@ void window_manage_all(void)
 {
     guint i, j, nchild;
     Window w, *children;
-    XWMHints *wmhints;
-    XWindowAttributes attrib;
+    ObtPropCookie *hints;
+    ObtAttributesCookie *attribs;
+    guint32 *wmhints;
+    guint nhints;
+    gint map_state;
+    gboolean override;
 
+    metrics_round_trip();
     if (!XQueryTree(obt_display, RootWindow(obt_display, ob_screen),
                     &w, &w, &children, &nchild)) {
         ob_debug("XQueryTree failed in window_manage_all");
         nchild = 0;
     }
 
+    /* ask for all of the hints before waiting for any of them, so it is one
+       round trip instead of one for each window */
+    hints = g_new(ObtPropCookie, nchild);
+    metrics_round_trip();
+    for (i = 0; i < nchild; i++)
+        hints[i] = obt_prop_request(children[i], XA_WM_HINTS, XA_WM_HINTS);
+
     /* remove all icon windows from the list */
     for (i = 0; i < nchild; i++) {
-        if (children[i] == None) continue;
-        wmhints = XGetWMHints(obt_display, children[i]);
-        if (wmhints) {
-            if ((wmhints->flags & IconWindowHint) &&
-                (wmhints->icon_window != children[i]))
+        if (children[i] == None) {
+            /* it was found to be an icon window already */
+            obt_prop_discard(&hints[i]);
+            continue;
+        }
+        /* the raw XWMHints, where [0] is the flags and [4] the icon window */
+        if (obt_prop_reply_array32(&hints[i], &wmhints, &nhints)) {
+            if (nhints >= 5 && (wmhints[0] & IconWindowHint) &&
+                (wmhints[4] != children[i]))
                 for (j = 0; j < nchild; j++)
-                    if (children[j] == wmhints->icon_window) {
+                    if (children[j] == wmhints[4]) {
                         /* XXX watch the window though */
                         children[j] = None;
                         break;
                     }
-            XFree(wmhints);
+            g_free(wmhints);
         }
     }
+    g_free(hints);
+
+    /* adopt all the windows as one batch.  holding the server means only
+       the first grab waits for it, instead of one round trip for each
+       window, and the windows are stacked and listed on the root window
+       once at the end instead of after each one */
+    grab_server(TRUE);
+    stacking_freeze();
+    client_list_freeze();
 
+    attribs = g_new(ObtAttributesCookie, nchild);
+    metrics_round_trip();
     for (i = 0; i < nchild; ++i) {
-        if (children[i] == None) continue;
-        if (window_find(children[i])) continue; /* skip our own windows */
-        if (XGetWindowAttributes(obt_display, children[i], &attrib)) {
-            if (attrib.map_state == IsUnmapped)
+        if (children[i] == None || window_find(children[i]))
+            attribs[i].win = None; /* skip icons and our own windows */
+        else
+            attribs[i] = obt_display_request_attributes(children[i]);
+    }
+
+    for (i = 0; i < nchild; ++i) {
+        if (attribs[i].win == None) continue;
+        if (window_find(children[i])) {
+            /* it became one of our own windows while managing the others */
+            obt_display_discard_attributes(&attribs[i]);
+            continue;
+        }
+        if (obt_display_reply_attributes(&attribs[i], &map_state, &override)) {
+            if (map_state == IsUnmapped)
                 ;
             else
                 window_manage(children[i]);
         }
     }
+    g_free(attribs);
+
+    client_list_thaw();
+    stacking_thaw();
+    grab_server(FALSE);
 
     if (children) XFree(children);
 }
@@ -177,6 +225,7 @@ void window_manage(Window win)
 
         /* is the window a docking app */
         is_dockapp = FALSE;
+        metrics_round_trip();
         if ((wmhints = XGetWMHints(obt_display, win))) {
             if ((wmhints->flags & StateHint) &&
                 wmhints->initial_state == WithdrawnState)
@@ -0,0 +1,656 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obbench.c for the Openbox window manager
+   Copyright (c) 2003-2008   Dana Jansens
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Drives a running Openbox with synthetic clients and measures how long it
+   takes to do things, writing the results as JSON.  It is normally run by
+   run.sh (make bench) against Openbox on an Xvfb server.
+
+   Openbox handles events in order, so a _NET_REQUEST_FRAME_EXTENTS for an
+   unmapped window of our own, which it answers right away by setting
+   _NET_FRAME_EXTENTS, tells when it has finished with everything sent
+   before it.  Every measurement ends with one of those, and the time one
+   takes on its own is reported as "sync_us".
+*/
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+/* how long to wait for openbox to answer, in seconds */
+#define TIMEOUT 5
+
+enum {
+    NET_SUPPORTING_WM_CHECK,
+    NET_REQUEST_FRAME_EXTENTS,
+    NET_FRAME_EXTENTS,
+    NET_CURRENT_DESKTOP,
+    NET_NUMBER_OF_DESKTOPS,
+    NET_WM_DESKTOP,
+    NET_WM_NAME,
+    NET_WM_ICON,
+    NET_WM_STRUT_PARTIAL,
+    UTF8_STRING,
+    NUM_ATOMS
+};
+
+static gchar *atom_names[NUM_ATOMS] = {
+    "_NET_SUPPORTING_WM_CHECK",
+    "_NET_REQUEST_FRAME_EXTENTS",
+    "_NET_FRAME_EXTENTS",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_NUMBER_OF_DESKTOPS",
+    "_NET_WM_DESKTOP",
+    "_NET_WM_NAME",
+    "_NET_WM_ICON",
+    "_NET_WM_STRUT_PARTIAL",
+    "UTF8_STRING"
+};
+
+static Display *d;
+static Window   root;
+static Window   sync_win;
+static Atom     atoms[NUM_ATOMS];
+/*! The latest server time seen, for messages that want a timestamp */
+static Time     last_time = CurrentTime;
+
+static gint     clients = 50;
+static gint     desktops = 4;
+static gint     icon_size = 48;
+static gint     transient_every = 10;
+static gint     struts = 2;
+static gint     repeat = 20;
+static gint     spam_seconds = 5;
+static gint     spam_rate = 200;
+static gint     wm_pid = 0;
+static gchar   *trace_dir = NULL;
+
+static Window  *windows;
+
+gint fail(const gchar *s) {
+    if (s)
+        fprintf(stderr, "%s\n", s);
+    else
+        fprintf
+            (stderr,
+             "Usage: obbench [OPTIONS]\n\n"
+             "Measures a running Openbox with synthetic clients and writes "
+             "the results as JSON.\n\n"
+             "Options:\n"
+             "    --help                Display this help and exit\n"
+             "    --display DISPLAY     Connect to this X display\n"
+             "    --output FILE         Write the results to FILE instead "
+             "of stdout\n"
+             "    --clients N           Number of windows to map (50)\n"
+             "    --desktops N          Spread the windows over N desktops "
+             "(4)\n"
+             "    --icon-size N         Give each window an NxN icon, 0 for "
+             "none (48)\n"
+             "    --transient-every N   Make every Nth window a transient, 0 "
+             "for none (10)\n"
+             "    --struts N            Give the first N windows a strut "
+             "(2)\n"
+             "    --repeat N            Times to repeat each timed action "
+             "(20)\n"
+             "    --spam-seconds N      How long to change titles for (5)\n"
+             "    --spam-rate N         Title changes per second (200)\n"
+             "    --wm-pid PID          Openbox's pid, to measure its CPU "
+             "use\n"
+             "    --trace-dir DIR       Where Openbox (run with --trace) "
+             "writes its traces\n");
+    return 1;
+}
+
+/*! Gets the next event, waiting until @deadline (a monotonic time) at
+  most.  Returns FALSE if no event came in time. */
+static gboolean next_event(XEvent *e, gint64 deadline)
+{
+    while (!XPending(d)) {
+        fd_set fds;
+        struct timeval tv;
+        gint64 left = deadline - g_get_monotonic_time();
+
+        if (left <= 0) return FALSE;
+        tv.tv_sec = left / G_USEC_PER_SEC;
+        tv.tv_usec = left % G_USEC_PER_SEC;
+        FD_ZERO(&fds);
+        FD_SET(ConnectionNumber(d), &fds);
+        select(ConnectionNumber(d) + 1, &fds, NULL, NULL, &tv);
+    }
+    XNextEvent(d, e);
+    if (e->type == PropertyNotify)
+        last_time = e->xproperty.time;
+    return TRUE;
+}
+
+static void send_root_message(Window w, Atom type, glong l0, glong l1)
+{
+    XEvent ce;
+
+    memset(&ce, 0, sizeof(ce));
+    ce.xclient.type = ClientMessage;
+    ce.xclient.message_type = type;
+    ce.xclient.display = d;
+    ce.xclient.window = w;
+    ce.xclient.format = 32;
+    ce.xclient.data.l[0] = l0;
+    ce.xclient.data.l[1] = l1;
+    XSendEvent(d, root, FALSE,
+               SubstructureNotifyMask | SubstructureRedirectMask, &ce);
+}
+
+/*! Waits until openbox has handled everything sent before.  Returns FALSE if
+  it did not answer in time. */
+static gboolean wm_sync(void)
+{
+    XEvent e;
+    gint64 deadline = g_get_monotonic_time() + TIMEOUT * G_USEC_PER_SEC;
+
+    send_root_message(sync_win, atoms[NET_REQUEST_FRAME_EXTENTS], 0, 0);
+    XFlush(d);
+
+    while (next_event(&e, deadline))
+        if (e.type == PropertyNotify && e.xproperty.window == sync_win &&
+            e.xproperty.atom == atoms[NET_FRAME_EXTENTS])
+            return TRUE;
+    return FALSE;
+}
+
+static gboolean wait_for_wm(void)
+{
+    gint64 deadline = g_get_monotonic_time() + TIMEOUT * G_USEC_PER_SEC;
+
+    while (g_get_monotonic_time() < deadline) {
+        Atom type;
+        gint format;
+        gulong n, after;
+        guchar *data = NULL;
+        gboolean found = FALSE;
+
+        if (XGetWindowProperty(d, root, atoms[NET_SUPPORTING_WM_CHECK],
+                               0, 1, False, XA_WINDOW, &type, &format,
+                               &n, &after, &data) == Success)
+        {
+            found = type == XA_WINDOW && n == 1;
+            if (data) XFree(data);
+        }
+        if (found) return TRUE;
+        g_usleep(G_USEC_PER_SEC / 20);
+    }
+    return FALSE;
+}
+
+static void set_title(Window w, const gchar *title)
+{
+    XStoreName(d, w, title);
+    XChangeProperty(d, w, atoms[NET_WM_NAME], atoms[UTF8_STRING], 8,
+                    PropModeReplace, (guchar*)title, strlen(title));
+}
+
+static Window make_client(gint i)
+{
+    Window w;
+    XClassHint class;
+    gchar *s;
+
+    w = XCreateSimpleWindow(d, root, 0, 0, 200 + (i % 5) * 40,
+                            150 + (i % 3) * 50, 0, 0, 0);
+
+    s = g_strdup_printf("bench%d", i);
+    class.res_name = s;
+    class.res_class = "ObBench";
+    XSetClassHint(d, w, &class);
+    g_free(s);
+
+    s = g_strdup_printf("Benchmark window %d", i);
+    set_title(w, s);
+    g_free(s);
+
+    if (desktops > 1) {
+        glong desktop = i % desktops;
+        XChangeProperty(d, w, atoms[NET_WM_DESKTOP], XA_CARDINAL, 32,
+                        PropModeReplace, (guchar*)&desktop, 1);
+    }
+
+    if (icon_size > 0) {
+        gulong *icon;
+        gint j, n = icon_size * icon_size;
+
+        icon = g_new(gulong, 2 + n);
+        icon[0] = icon[1] = icon_size;
+        for (j = 0; j < n; ++j)
+            icon[2 + j] = 0xff000000 | ((i * 0x1f3d5b + j * 0x010101) &
+                                        0xffffff);
+        XChangeProperty(d, w, atoms[NET_WM_ICON], XA_CARDINAL, 32,
+                        PropModeReplace, (guchar*)icon, 2 + n);
+        g_free(icon);
+    }
+
+    /* a transient for the window before it, on the same desktop */
+    if (transient_every > 0 && i >= desktops &&
+        i % transient_every == transient_every - 1)
+        XSetTransientForHint(d, w, windows[i - desktops]);
+
+    if (i < struts) {
+        glong strut[12];
+
+        memset(strut, 0, sizeof(strut));
+        /* alternate between the top and bottom of the screen */
+        strut[2 + i % 2] = 20;
+        strut[9 + (i % 2) * 2] = DisplayWidth(d, DefaultScreen(d)) - 1;
+        XChangeProperty(d, w, atoms[NET_WM_STRUT_PARTIAL], XA_CARDINAL, 32,
+                        PropModeReplace, (guchar*)strut, 12);
+    }
+
+    return w;
+}
+
+static gint cmp_gint64(gconstpointer a, gconstpointer b)
+{
+    const gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*! Writes the summary of a set of times in microseconds */
+static void write_stats(GString *out, const gchar *name, GArray *t)
+{
+    gint64 sum = 0;
+    guint i;
+
+    g_string_append_printf(out, "    \"%s\": {\"count\": %u", name, t->len);
+    if (t->len) {
+        g_array_sort(t, cmp_gint64);
+        for (i = 0; i < t->len; ++i)
+            sum += g_array_index(t, gint64, i);
+        g_string_append_printf(out,
+                               ", \"avg\": %" G_GINT64_FORMAT
+                               ", \"median\": %" G_GINT64_FORMAT
+                               ", \"p95\": %" G_GINT64_FORMAT
+                               ", \"max\": %" G_GINT64_FORMAT,
+                               sum / t->len,
+                               g_array_index(t, gint64, t->len / 2),
+                               g_array_index(t, gint64, t->len * 95 / 100),
+                               g_array_index(t, gint64, t->len - 1));
+    }
+    g_string_append(out, "}");
+}
+
+static void add_time(GArray *t, gint64 start)
+{
+    gint64 usec = g_get_monotonic_time() - start;
+    g_array_append_val(t, usec);
+}
+
+/*! Returns the CPU time openbox has used in microseconds, or -1 */
+static gint64 wm_cpu_time(void)
+{
+    gchar *path, *stat = NULL, *p;
+    gulong utime, stime;
+    gint64 ret = -1;
+
+    if (!wm_pid) return -1;
+
+    path = g_strdup_printf("/proc/%d/stat", wm_pid);
+    /* the fields after the command, which is in brackets and may contain
+       anything */
+    if (g_file_get_contents(path, &stat, NULL, NULL) &&
+        (p = strrchr(stat, ')')) &&
+        sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) == 2)
+    {
+        ret = (gint64)(utime + stime) * G_USEC_PER_SEC / sysconf(_SC_CLK_TCK);
+    }
+    g_free(stat);
+    g_free(path);
+    return ret;
+}
+
+/*! Asks openbox to write out its trace, and returns the file's name */
+static gchar* dump_trace(void)
+{
+    gchar *prefix, *found = NULL;
+    gint64 deadline;
+    GDir *dir;
+    const gchar *name;
+
+    if (!wm_pid || !trace_dir) return NULL;
+
+    /* remove any old ones so the new one can be told apart */
+    prefix = g_strdup_printf("trace-%d-", wm_pid);
+    if ((dir = g_dir_open(trace_dir, 0, NULL))) {
+        while ((name = g_dir_read_name(dir)))
+            if (g_str_has_prefix(name, prefix)) {
+                gchar *path = g_build_filename(trace_dir, name, NULL);
+                unlink(path);
+                g_free(path);
+            }
+        g_dir_close(dir);
+    }
+
+    kill(wm_pid, SIGPROF);
+    /* the trace is written by the time openbox answers a sync */
+    wm_sync();
+
+    deadline = g_get_monotonic_time() + TIMEOUT * G_USEC_PER_SEC;
+    while (!found && g_get_monotonic_time() < deadline) {
+        if ((dir = g_dir_open(trace_dir, 0, NULL))) {
+            while (!found && (name = g_dir_read_name(dir)))
+                if (g_str_has_prefix(name, prefix))
+                    found = g_build_filename(trace_dir, name, NULL);
+            g_dir_close(dir);
+        }
+        if (!found) {
+            g_usleep(G_USEC_PER_SEC / 20);
+            wm_sync();
+        }
+    }
+    g_free(prefix);
+    return found;
+}
+
+typedef struct {
+    gchar name[64];
+    gint64 ts;
+} Open;
+
+/*! Reads a trace written by openbox --trace and adds the length of each
+  span to @spans, which maps the span names to arrays of times */
+static void read_trace(const gchar *path, GHashTable *spans)
+{
+    gchar *contents, **lines, **it;
+    GArray *stack;
+
+    if (!g_file_get_contents(path, &contents, NULL, NULL)) return;
+
+    stack = g_array_new(FALSE, FALSE, sizeof(Open));
+    lines = g_strsplit(contents, "\n", -1);
+    for (it = lines; *it; ++it) {
+        Open o;
+        gchar ph;
+
+        if (sscanf(*it, "{\"name\":\"%63[^\"]\",\"cat\":\"openbox\","
+                   "\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT,
+                   o.name, &ph, &o.ts) != 3)
+            continue;
+
+        if (ph == 'B')
+            g_array_append_val(stack, o);
+        else if (ph == 'E' && stack->len) {
+            const Open *b = &g_array_index(stack, Open, stack->len - 1);
+            GArray *t;
+            gint64 usec;
+
+            if ((t = g_hash_table_lookup(spans, b->name)) == NULL) {
+                t = g_array_new(FALSE, FALSE, sizeof(gint64));
+                g_hash_table_insert(spans, g_strdup(b->name), t);
+            }
+            usec = o.ts - b->ts;
+            g_array_append_val(t, usec);
+            g_array_set_size(stack, stack->len - 1);
+        }
+    }
+    g_strfreev(lines);
+    g_array_free(stack, TRUE);
+    g_free(contents);
+}
+
+static void free_times(gpointer t)
+{
+    g_array_free(t, TRUE);
+}
+
+static gint name_cmp(gconstpointer a, gconstpointer b)
+{
+    return strcmp(a, b);
+}
+
+gint main(gint argc, gchar **argv)
+{
+    gchar *dname = NULL, *output = NULL;
+    GArray *sync_t, *manage_t, *cycle_t, *desktop_t;
+    GHashTable *spans;
+    GString *out;
+    gchar *trace;
+    GList *names, *it;
+    gint i, r, xtest_ev, xtest_err, xtest_major, xtest_minor, nspam;
+    gint64 start, cpu_start, cpu_end, wall, drain, changes;
+
+    for (i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--help"))
+            return fail(NULL);
+        else if (i == argc - 1)
+            return fail(NULL);
+        else if (!strcmp(argv[i], "--display"))
+            dname = argv[++i];
+        else if (!strcmp(argv[i], "--output"))
+            output = argv[++i];
+        else if (!strcmp(argv[i], "--clients"))
+            clients = MAX(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--desktops"))
+            desktops = MAX(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--icon-size"))
+            icon_size = MAX(0, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--transient-every"))
+            transient_every = MAX(0, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--struts"))
+            struts = MAX(0, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--repeat"))
+            repeat = MAX(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--spam-seconds"))
+            spam_seconds = MAX(0, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--spam-rate"))
+            spam_rate = MAX(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--wm-pid"))
+            wm_pid = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--trace-dir"))
+            trace_dir = argv[++i];
+        else
+            return fail(NULL);
+    }
+
+    d = XOpenDisplay(dname);
+    if (!d) {
+        return fail("Unable to find an X display. "
+                    "Ensure you have permission to connect to the display.");
+    }
+    root = RootWindow(d, DefaultScreen(d));
+    XInternAtoms(d, atom_names, NUM_ATOMS, False, atoms);
+
+    if (!wait_for_wm())
+        return fail("No window manager is running");
+
+    XSelectInput(d, root, SubstructureNotifyMask | PropertyChangeMask);
+    sync_win = XCreateSimpleWindow(d, root, 0, 0, 1, 1, 0, 0, 0);
+    XSelectInput(d, sync_win, PropertyChangeMask);
+
+    sync_t = g_array_new(FALSE, FALSE, sizeof(gint64));
+    manage_t = g_array_new(FALSE, FALSE, sizeof(gint64));
+    cycle_t = g_array_new(FALSE, FALSE, sizeof(gint64));
+    desktop_t = g_array_new(FALSE, FALSE, sizeof(gint64));
+    spans = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                  free_times);
+
+    send_root_message(root, atoms[NET_NUMBER_OF_DESKTOPS], desktops, 0);
+    send_root_message(root, atoms[NET_CURRENT_DESKTOP], 0, last_time);
+    if (!wm_sync())
+        return fail("Openbox did not answer");
+
+    for (r = 0; r < repeat; ++r) {
+        start = g_get_monotonic_time();
+        if (wm_sync()) add_time(sync_t, start);
+    }
+
+    /* map the windows one at a time */
+    windows = g_new(Window, clients);
+    for (i = 0; i < clients; ++i) {
+        windows[i] = make_client(i);
+        start = g_get_monotonic_time();
+        XMapWindow(d, windows[i]);
+        if (wm_sync()) add_time(manage_t, start);
+    }
+
+    /* open the focus cycling popup with alt-tab, until it is mapped */
+    if (XTestQueryExtension(d, &xtest_ev, &xtest_err,
+                            &xtest_major, &xtest_minor))
+    {
+        const KeyCode alt = XKeysymToKeycode(d, XK_Alt_L);
+        const KeyCode tab = XKeysymToKeycode(d, XK_Tab);
+
+        for (r = 0; r < repeat; ++r) {
+            XEvent e;
+            gint64 deadline;
+
+            start = g_get_monotonic_time();
+            XTestFakeKeyEvent(d, alt, True, CurrentTime);
+            XTestFakeKeyEvent(d, tab, True, CurrentTime);
+            XTestFakeKeyEvent(d, tab, False, CurrentTime);
+            XFlush(d);
+
+            deadline = start + TIMEOUT * G_USEC_PER_SEC;
+            while (next_event(&e, deadline))
+                if (e.type == MapNotify && e.xmap.event == root &&
+                    e.xmap.override_redirect)
+                {
+                    add_time(cycle_t, start);
+                    break;
+                }
+
+            XTestFakeKeyEvent(d, alt, False, CurrentTime);
+            wm_sync();
+        }
+    }
+
+    /* move through the desktops */
+    if (desktops > 1)
+        for (r = 0; r < repeat; ++r) {
+            start = g_get_monotonic_time();
+            send_root_message(root, atoms[NET_CURRENT_DESKTOP],
+                              (r + 1) % desktops, last_time);
+            if (wm_sync()) add_time(desktop_t, start);
+        }
+    send_root_message(root, atoms[NET_CURRENT_DESKTOP], 0, last_time);
+    wm_sync();
+
+    /* the spans from everything so far, before the title changes below
+       push them out of openbox's trace buffer */
+    if ((trace = dump_trace())) {
+        read_trace(trace, spans);
+        g_free(trace);
+    }
+
+    /* change the titles of the windows on the current desktop at a steady
+       rate, and see how much cpu openbox uses to keep up */
+    nspam = (clients + desktops - 1) / desktops;
+    changes = 0;
+    cpu_start = wm_cpu_time();
+    start = g_get_monotonic_time();
+    while (g_get_monotonic_time() - start <
+           (gint64)spam_seconds * G_USEC_PER_SEC)
+    {
+        gchar *s;
+        gint64 next;
+
+        s = g_strdup_printf("Benchmark window %d (%" G_GINT64_FORMAT ")",
+                            (gint)(changes % nspam) * desktops, changes);
+        set_title(windows[(changes % nspam) * desktops], s);
+        g_free(s);
+        XFlush(d);
+        ++changes;
+
+        /* drop the PropertyNotify events for our own changes */
+        while (XPending(d)) {
+            XEvent e;
+            XNextEvent(d, &e);
+        }
+
+        next = start + changes * G_USEC_PER_SEC / spam_rate;
+        if (next > g_get_monotonic_time())
+            g_usleep(next - g_get_monotonic_time());
+    }
+    drain = g_get_monotonic_time();
+    wm_sync();
+    cpu_end = wm_cpu_time();
+    wall = g_get_monotonic_time() - start;
+    drain = g_get_monotonic_time() - drain;
+
+    out = g_string_new("{\n  \"config\": {");
+    g_string_append_printf(out,
+                           "\"clients\": %d, \"desktops\": %d, "
+                           "\"icon_size\": %d, \"transient_every\": %d, "
+                           "\"struts\": %d, \"repeat\": %d, "
+                           "\"spam_seconds\": %d, \"spam_rate\": %d},\n",
+                           clients, desktops, icon_size, transient_every,
+                           struts, repeat, spam_seconds, spam_rate);
+    g_string_append(out, "  \"results\": {\n");
+    write_stats(out, "sync_us", sync_t);
+    g_string_append(out, ",\n");
+    write_stats(out, "manage_us", manage_t);
+    g_string_append(out, ",\n");
+    write_stats(out, "focus_cycle_popup_us", cycle_t);
+    g_string_append(out, ",\n");
+    write_stats(out, "desktop_switch_us", desktop_t);
+    g_string_append(out, ",\n");
+    g_string_append_printf(out,
+                           "    \"title_spam\": {\"changes\": %"
+                           G_GINT64_FORMAT ", \"drain_us\": %"
+                           G_GINT64_FORMAT ", \"cpu_percent\": %.1f}",
+                           changes, drain,
+                           (cpu_start >= 0 && cpu_end >= 0 && wall > 0 ?
+                            (cpu_end - cpu_start) * 100.0 / wall : -1.0));
+    g_string_append(out, "\n  },\n  \"spans_us\": {");
+    names = g_list_sort(g_hash_table_get_keys(spans), name_cmp);
+    for (it = names; it; it = g_list_next(it)) {
+        g_string_append(out, it == names ? "\n" : ",\n");
+        write_stats(out, it->data, g_hash_table_lookup(spans, it->data));
+    }
+    g_list_free(names);
+    g_string_append(out, "\n  }\n}\n");
+
+    if (output) {
+        GError *err = NULL;
+        if (!g_file_set_contents(output, out->str, out->len, &err)) {
+            fprintf(stderr, "Unable to write %s: %s\n", output, err->message);
+            g_error_free(err);
+            return 1;
+        }
+    }
+    else
+        fputs(out->str, stdout);
+    g_string_free(out, TRUE);
+
+    for (i = 0; i < clients; ++i)
+        XDestroyWindow(d, windows[i]);
+    XDestroyWindow(d, sync_win);
+    XCloseDisplay(d);
+
+    g_free(windows);
+    g_array_free(sync_t, TRUE);
+    g_array_free(manage_t, TRUE);
+    g_array_free(cycle_t, TRUE);
+    g_array_free(desktop_t, TRUE);
+    g_hash_table_destroy(spans);
+    return 0;
+}
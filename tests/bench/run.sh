@@ -0,0 +1,69 @@
+#!/bin/sh
+#
+# Runs the benchmarks against a private Xvfb server, for "make bench".
+#
+#   OPENBOX        the openbox binary to measure (openbox/openbox)
+#   OBBENCH        the benchmark driver (tests/bench/obbench)
+#   RC             the rc.xml to run openbox with (data/rc.xml)
+#   BENCH_OUTPUT   where to write the JSON results (bench-results.json)
+#
+# Any arguments are passed on to obbench, see obbench --help.
+
+OPENBOX=${OPENBOX:-openbox/openbox}
+OBBENCH=${OBBENCH:-tests/bench/obbench}
+RC=${RC:-data/rc.xml}
+BENCH_OUTPUT=${BENCH_OUTPUT:-bench-results.json}
+
+if ! command -v Xvfb >/dev/null 2>&1; then
+    echo "Xvfb is needed to run the benchmarks" >&2
+    exit 1
+fi
+
+# find a free display
+disp=90
+while [ -e /tmp/.X$disp-lock ] || [ -e /tmp/.X11-unix/X$disp ]; do
+    disp=$((disp + 1))
+done
+
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/obbench.XXXXXX") || exit 1
+mkdir -p "$tmp/cache/openbox" "$tmp/config"
+
+xvfb_pid=
+ob_pid=
+cleanup() {
+    [ -n "$ob_pid" ] && kill $ob_pid 2>/dev/null
+    [ -n "$xvfb_pid" ] && kill $xvfb_pid 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$tmp"
+}
+trap cleanup EXIT INT TERM
+
+Xvfb :$disp -screen 0 1280x1024x24 -nolisten tcp >"$tmp/xvfb.log" 2>&1 &
+xvfb_pid=$!
+
+tries=0
+while [ ! -e /tmp/.X11-unix/X$disp ]; do
+    tries=$((tries + 1))
+    if [ $tries -gt 50 ] || ! kill -0 $xvfb_pid 2>/dev/null; then
+        echo "Xvfb did not start:" >&2
+        cat "$tmp/xvfb.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+# keep openbox away from the user's own config and cache
+DISPLAY=:$disp XDG_CACHE_HOME="$tmp/cache" XDG_CONFIG_HOME="$tmp/config" \
+    "$OPENBOX" --sm-disable --trace --config-file "$RC" \
+    >"$tmp/openbox.log" 2>&1 &
+ob_pid=$!
+
+if ! "$OBBENCH" --display :$disp --wm-pid $ob_pid \
+    --trace-dir "$tmp/cache/openbox" --output "$BENCH_OUTPUT" "$@"
+then
+    echo "The benchmarks failed, openbox said:" >&2
+    cat "$tmp/openbox.log" >&2
+    exit 1
+fi
+
+echo "Wrote the results to $BENCH_OUTPUT"
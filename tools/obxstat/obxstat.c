@@ -0,0 +1,134 @@
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/select.h>
+#include <glib.h>
+
+/* these match ObMetricsRequest in openbox/metrics.h */
+#define METRICS_PUBLISH 0
+#define METRICS_RESET   1
+
+/* how long to wait for openbox to answer, in seconds */
+#define TIMEOUT 2
+
+gint fail(const gchar *s) {
+    if (s)
+        fprintf(stderr, "%s\n", s);
+    else
+        fprintf
+            (stderr,
+             "Usage: obxstat [OPTIONS]\n\n"
+             "Shows the performance counters of the running Openbox.\n\n"
+             "Options:\n"
+             "    --help              Display this help and exit\n"
+             "    --display DISPLAY   Connect to this X display\n"
+             "    --reset             Start counting again from zero\n");
+    return 1;
+}
+
+static void send_request(Display *d, Window root, Atom metrics, glong req)
+{
+    XEvent ce;
+
+    memset(&ce, 0, sizeof(ce));
+    ce.xclient.type = ClientMessage;
+    ce.xclient.message_type = metrics;
+    ce.xclient.display = d;
+    ce.xclient.window = root;
+    ce.xclient.format = 32;
+    ce.xclient.data.l[0] = req;
+    XSendEvent(d, root, FALSE,
+               SubstructureNotifyMask | SubstructureRedirectMask, &ce);
+}
+
+/*! Waits for the property to be changed on the root window, and returns
+  FALSE if that does not happen in time */
+static gboolean wait_for_property(Display *d, Window root, Atom metrics)
+{
+    XEvent ev;
+    fd_set fds;
+    struct timeval tv;
+
+    tv.tv_sec = TIMEOUT;
+    tv.tv_usec = 0;
+    while (1) {
+        while (XPending(d)) {
+            XNextEvent(d, &ev);
+            if (ev.type == PropertyNotify && ev.xproperty.window == root &&
+                ev.xproperty.atom == metrics &&
+                ev.xproperty.state == PropertyNewValue)
+                return TRUE;
+        }
+
+        FD_ZERO(&fds);
+        FD_SET(ConnectionNumber(d), &fds);
+        if (select(ConnectionNumber(d) + 1, &fds, NULL, NULL, &tv) <= 0)
+            return FALSE;
+    }
+}
+
+gint main(gint argc, gchar **argv)
+{
+    Display *d;
+    Window root;
+    Atom metrics, utf8, type;
+    gint i, format;
+    gulong n, after;
+    guchar *data;
+    gboolean reset = FALSE;
+    gchar *dname = NULL;
+
+    for (i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--help")) {
+            return fail(NULL);
+        }
+        else if (!strcmp(argv[i], "--reset"))
+            reset = TRUE;
+        else if (!strcmp(argv[i], "--display")) {
+            if (++i == argc)
+                return fail(NULL);
+            dname = argv[i];
+        }
+        else
+            return fail(NULL);
+    }
+
+    d = XOpenDisplay(dname);
+    if (!d) {
+        return fail("Unable to find an X display. "
+                    "Ensure you have permission to connect to the display.");
+    }
+
+    root = RootWindow(d, DefaultScreen(d));
+    metrics = XInternAtom(d, "_OB_METRICS", FALSE);
+    utf8 = XInternAtom(d, "UTF8_STRING", FALSE);
+
+    if (reset) {
+        send_request(d, root, metrics, METRICS_RESET);
+        XCloseDisplay(d);
+        return 0;
+    }
+
+    XSelectInput(d, root, PropertyChangeMask);
+    send_request(d, root, metrics, METRICS_PUBLISH);
+    XFlush(d);
+
+    if (!wait_for_property(d, root, metrics))
+        return fail("Openbox did not answer. Is it running?");
+
+    if (XGetWindowProperty(d, root, metrics, 0l, G_MAXLONG, FALSE, utf8,
+                           &type, &format, &n, &after, &data) != Success ||
+        type != utf8 || format != 8)
+    {
+        return fail("Unable to read the counters from Openbox");
+    }
+
+    fwrite(data, 1, n, stdout);
+    XFree(data);
+
+    XCloseDisplay(d);
+
+    return 0;
+}